@@ -1,4 +1,10 @@
 #include "main.h"
+#include "scc_prepass.h"
+#include "vertex_order.h"
+#include "../common/numa_alloc.h"
+#include "../common/solver_server.h"
+#include <charconv>
+#include <string>
 
 // Block size for optimized Floyd-Warshall
 #define B 32
@@ -7,6 +13,10 @@
 // Keep original INF value for output compatibility
 #define INF 1073741823  // 2^30 - 1
 
+// SCC components at least this large go to the GPU; smaller ones are solved
+// concurrently on host threads
+#define SCC_GPU_MIN_VERTICES 512
+
 // Device function for min operation
 __device__ __forceinline__ int device_min(int a, int b) {
     return (a < b) ? a : b;
@@ -29,17 +39,17 @@ void check_hip_error(hipError_t err, const char* msg) {
     }
 }
 
-// Initialize distance matrix with INF and 0 on diagonal
+// Initialize distance matrix with INF and 0 on diagonal. Rows are split
+// across the host pool so that first touch spreads the pages over the NUMA
+// nodes the same way the row-parallel passes split them later.
 void initialize_distance_matrix(int* dist, int V) {
-    for (int i = 0; i < V; i++) {
-        for (int j = 0; j < V; j++) {
-            if (i == j) {
-                dist[i * V + j] = 0;
-            } else {
-                dist[i * V + j] = INF;
-            }
+    parallel_for_ranges(V, [&](size_t b, size_t e, int) {
+        for (size_t i = b; i < e; i++) {
+            int* row = dist + i * V;
+            std::fill(row, row + V, INF);
+            row[i] = 0;
         }
-    }
+    });
 }
 
 // Add edge to distance matrix
@@ -56,6 +66,26 @@ __device__ __forceinline__ void store_if_valid(int* __restrict__ a, int V, int i
     if (i < V && j < V) a[i * V + j] = v;
 }
 
+// Tile summaries: tile_min[ib * nB + jb] is the smallest entry of tile
+// (ib, jb), so INF means the whole tile is INF. Phase 2 publishes the
+// summaries of row kb and column kb right after updating them; phase 3 reads
+// them in the same round to skip no-op tiles and no-op threads. Each warp
+// reduces with shuffles first, so only one lane per warp (16 per tile)
+// touches the shared minimum.
+__device__ __forceinline__ void publish_tile_min(int* __restrict__ tile_min, int V, int ib, int jb,
+                                                 int v, int* sMin) {
+    #pragma unroll
+    for (int offset = warpSize / 2; offset > 0; offset >>= 1) {
+        v = device_min(v, __shfl_xor(v, offset));
+    }
+    if ((threadIdx.y * B + threadIdx.x) % warpSize == 0) atomicMin(sMin, v);
+    __syncthreads();
+    if (threadIdx.x == 0 && threadIdx.y == 0) {
+        const int nB = (V + B - 1) / B;
+        tile_min[ib * nB + jb] = *sMin;
+    }
+}
+
 // Phase 1: Update pivot block (kb,kb)
 __global__ __launch_bounds__(1024, 2) void fw_phase1(int* __restrict__ dist, int V, int kb) {
     __shared__ int s[B][PAD];
@@ -105,7 +135,7 @@ __global__ __launch_bounds__(1024, 2) void fw_phase1_full(int* __restrict__ dist
 }
 
 // Phase 2-row: Update row blocks (kb, jb), jb != kb
-__global__ __launch_bounds__(1024, 2) void fw_phase2_row(int* __restrict__ dist, int V, int kb) {
+__global__ __launch_bounds__(1024, 2) void fw_phase2_row(int* __restrict__ dist, int* __restrict__ tile_min, int V, int kb) {
     __shared__ int sPivot[B][PAD];
     __shared__ int sRow[B][PAD];
 
@@ -115,6 +145,9 @@ __global__ __launch_bounds__(1024, 2) void fw_phase2_row(int* __restrict__ dist,
     const int i = kb * B + threadIdx.y;
     const int j = jb * B + threadIdx.x;
 
+    __shared__ int sMin;
+    if (threadIdx.x == 0 && threadIdx.y == 0) sMin = INF;
+
     // Load pivot block and current row block
     sPivot[threadIdx.y][threadIdx.x] = load_or_inf(dist, V, kb * B + threadIdx.y, kb * B + threadIdx.x);
     sRow[threadIdx.y][threadIdx.x] = load_or_inf(dist, V, i, j);
@@ -132,10 +165,11 @@ __global__ __launch_bounds__(1024, 2) void fw_phase2_row(int* __restrict__ dist,
     }
 
     store_if_valid(dist, V, i, j, sRow[threadIdx.y][threadIdx.x]);
+    publish_tile_min(tile_min, V, kb, jb, sRow[threadIdx.y][threadIdx.x], &sMin);
 }
 
 // Phase 2-col: Update column blocks (ib, kb), ib != kb
-__global__ __launch_bounds__(1024, 2) void fw_phase2_col(int* __restrict__ dist, int V, int kb) {
+__global__ __launch_bounds__(1024, 2) void fw_phase2_col(int* __restrict__ dist, int* __restrict__ tile_min, int V, int kb) {
     __shared__ int sPivot[B][PAD];
     __shared__ int sCol[B][PAD];
 
@@ -145,6 +179,9 @@ __global__ __launch_bounds__(1024, 2) void fw_phase2_col(int* __restrict__ dist,
     const int i = ib * B + threadIdx.y;
     const int j = kb * B + threadIdx.x;
 
+    __shared__ int sMin;
+    if (threadIdx.x == 0 && threadIdx.y == 0) sMin = INF;
+
     // Load pivot block and current column block
     sPivot[threadIdx.y][threadIdx.x] = load_or_inf(dist, V, kb * B + threadIdx.y, kb * B + threadIdx.x);
     sCol[threadIdx.y][threadIdx.x] = load_or_inf(dist, V, i, j);
@@ -162,10 +199,11 @@ __global__ __launch_bounds__(1024, 2) void fw_phase2_col(int* __restrict__ dist,
     }
 
     store_if_valid(dist, V, i, j, sCol[threadIdx.y][threadIdx.x]);
+    publish_tile_min(tile_min, V, ib, kb, sCol[threadIdx.y][threadIdx.x], &sMin);
 }
 
 // Phase 2-row specialized for full tiles (KLEN == B)
-__global__ __launch_bounds__(1024, 2) void fw_phase2_row_full(int* __restrict__ dist, int V, int kb) {
+__global__ __launch_bounds__(1024, 2) void fw_phase2_row_full(int* __restrict__ dist, int* __restrict__ tile_min, int V, int kb) {
     __shared__ int sPivot[B][PAD];
     __shared__ int sRow[B][PAD];
 
@@ -175,6 +213,9 @@ __global__ __launch_bounds__(1024, 2) void fw_phase2_row_full(int* __restrict__
     const int i = kb * B + threadIdx.y;
     const int j = jb * B + threadIdx.x;
 
+    __shared__ int sMin;
+    if (threadIdx.x == 0 && threadIdx.y == 0) sMin = INF;
+
     // Load pivot block and current row block
     sPivot[threadIdx.y][threadIdx.x] = load_or_inf(dist, V, kb * B + threadIdx.y, kb * B + threadIdx.x);
     sRow[threadIdx.y][threadIdx.x] = load_or_inf(dist, V, i, j);
@@ -190,10 +231,11 @@ __global__ __launch_bounds__(1024, 2) void fw_phase2_row_full(int* __restrict__
     }
 
     store_if_valid(dist, V, i, j, sRow[threadIdx.y][threadIdx.x]);
+    publish_tile_min(tile_min, V, kb, jb, sRow[threadIdx.y][threadIdx.x], &sMin);
 }
 
 // Phase 2-col specialized for full tiles (KLEN == B)
-__global__ __launch_bounds__(1024, 2) void fw_phase2_col_full(int* __restrict__ dist, int V, int kb) {
+__global__ __launch_bounds__(1024, 2) void fw_phase2_col_full(int* __restrict__ dist, int* __restrict__ tile_min, int V, int kb) {
     __shared__ int sPivot[B][PAD];
     __shared__ int sCol[B][PAD];
 
@@ -203,6 +245,9 @@ __global__ __launch_bounds__(1024, 2) void fw_phase2_col_full(int* __restrict__
     const int i = ib * B + threadIdx.y;
     const int j = kb * B + threadIdx.x;
 
+    __shared__ int sMin;
+    if (threadIdx.x == 0 && threadIdx.y == 0) sMin = INF;
+
     // Load pivot block and current column block
     sPivot[threadIdx.y][threadIdx.x] = load_or_inf(dist, V, kb * B + threadIdx.y, kb * B + threadIdx.x);
     sCol[threadIdx.y][threadIdx.x] = load_or_inf(dist, V, i, j);
@@ -218,11 +263,12 @@ __global__ __launch_bounds__(1024, 2) void fw_phase2_col_full(int* __restrict__
     }
 
     store_if_valid(dist, V, i, j, sCol[threadIdx.y][threadIdx.x]);
+    publish_tile_min(tile_min, V, ib, kb, sCol[threadIdx.y][threadIdx.x], &sMin);
 }
 
 // Phase 3: Update remaining blocks (ib, jb), ib != kb, jb != kb
 // Optimized version that skips empty blocks at launch level
-__global__ __launch_bounds__(1024, 2) void fw_phase3(int* __restrict__ dist, int V, int kb) {
+__global__ __launch_bounds__(1024, 2) void fw_phase3(int* __restrict__ dist, const int* __restrict__ tile_min, int V, int kb) {
     // Map reduced grid coordinates to actual block indices, skipping kb
     const int ib = blockIdx.y + (blockIdx.y >= kb);
     const int jb = blockIdx.x + (blockIdx.x >= kb);
@@ -231,6 +277,11 @@ __global__ __launch_bounds__(1024, 2) void fw_phase3(int* __restrict__ dist, int
     // 如果这是内部整块位置（且 kb 也是整块），交给 micro-tiled 版本处理，这里直接跳过
     if ((kb < fullBlocks) && (ib < fullBlocks) && (jb < fullBlocks)) return;
 
+    // Row tile (ib,kb) or column tile (kb,jb) all INF: nothing can improve
+    const int nB = (V + B - 1) / B;
+    const int bound = add_sat(tile_min[ib * nB + kb], tile_min[kb * nB + jb]);
+    if (bound >= INF) return;
+
     __shared__ int sRow[B][PAD];
     __shared__ int sCol[B][PAD];
     __shared__ int sBlk[B][PAD];
@@ -246,6 +297,11 @@ __global__ __launch_bounds__(1024, 2) void fw_phase3(int* __restrict__ dist, int
 
     const int KLEN = device_min(B, V - kb * B);
 
+    // Every path through this k tile costs at least `bound`; threads whose
+    // entry is already that short neither compute nor store
+    const int cur0 = sBlk[threadIdx.y][threadIdx.x];
+    if (bound >= cur0) return;
+
     // Inner k loop in shared memory
     #pragma unroll
     for (int kk = 0; kk < KLEN; ++kk) {
@@ -256,16 +312,21 @@ __global__ __launch_bounds__(1024, 2) void fw_phase3(int* __restrict__ dist, int
         // and sBlk[ty][tx] is only updated by this thread
     }
 
-    store_if_valid(dist, V, i, j, sBlk[threadIdx.y][threadIdx.x]);
+    if (sBlk[threadIdx.y][threadIdx.x] < cur0) store_if_valid(dist, V, i, j, sBlk[threadIdx.y][threadIdx.x]);
 }
 
 // Phase 3 specialized for full tiles with micro-tiling optimization
 // Each thread computes 2 columns to reduce shared memory pressure
 // Use 16×32=512 threads for correct micro-tiling
-__global__ __launch_bounds__(512, 4) void fw_phase3_full_microtiled(int* __restrict__ dist, int V, int kb) {
+__global__ __launch_bounds__(512, 4) void fw_phase3_full_microtiled(int* __restrict__ dist, const int* __restrict__ tile_min, int V, int kb) {
     const int ib = blockIdx.y + (blockIdx.y >= kb);
     const int jb = blockIdx.x + (blockIdx.x >= kb);
 
+    // Row tile (ib,kb) or column tile (kb,jb) all INF: nothing can improve
+    const int nB = (V + B - 1) / B;
+    const int bound = add_sat(tile_min[ib * nB + kb], tile_min[kb * nB + jb]);
+    if (bound >= INF) return;
+
     __shared__ int sRow[B][PAD];
     __shared__ int sCol[B][PAD];
     __shared__ int sBlk[B][PAD];
@@ -288,8 +349,13 @@ __global__ __launch_bounds__(512, 4) void fw_phase3_full_microtiled(int* __restr
     sBlk[ty][tx + (B >> 1)]   = load_or_inf(dist, V, i,            j1);
     __syncthreads();
 
-    int acc0 = sBlk[ty][tx];
-    int acc1 = sBlk[ty][tx + (B >> 1)];
+    const int cur0 = sBlk[ty][tx];
+    const int cur1 = sBlk[ty][tx + (B >> 1)];
+    // Both entries already within the lower bound: no path can improve them
+    if (bound >= cur0 && bound >= cur1) return;
+
+    int acc0 = cur0;
+    int acc1 = cur1;
 
     #pragma unroll 32
     for (int kk = 0; kk < B; ++kk) {
@@ -298,39 +364,65 @@ __global__ __launch_bounds__(512, 4) void fw_phase3_full_microtiled(int* __restr
         acc1 = device_min(acc1, add_sat(r, sCol[kk][tx + (B >> 1)]));
     }
 
-    store_if_valid(dist, V, i, j0, acc0);
-    store_if_valid(dist, V, i, j1, acc1);
+    if (acc0 < cur0) store_if_valid(dist, V, i, j0, acc0);
+    if (acc1 < cur1) store_if_valid(dist, V, i, j1, acc1);
+}
+
+// Streams, events and device buffers outlive a single solve so that a
+// resident server (--serve) creates them once; buffers only grow
+struct GpuContext {
+    hipStream_t s_p1, s_row, s_col, s_p3;
+    hipEvent_t e_pivot_done, e_row_done, e_col_done, e_p3_done;
+    int *d_dist = nullptr, *d_tile_min = nullptr;
+    size_t dist_bytes = 0, tile_bytes = 0;
+};
+
+static GpuContext& gpu_context() {
+    static GpuContext* ctx = nullptr;
+    if (ctx) return *ctx;
+    ctx = new GpuContext;
+
+    // Create independent streams for each phase to avoid default stream implicit sync
+    check_hip_error(hipStreamCreate(&ctx->s_p1), "create phase1 stream");
+    check_hip_error(hipStreamCreate(&ctx->s_row), "create row stream");
+    check_hip_error(hipStreamCreate(&ctx->s_col), "create col stream");
+    check_hip_error(hipStreamCreate(&ctx->s_p3), "create phase3 stream");
+
+    // Persistent events with timing disabled for better performance
+    check_hip_error(hipEventCreateWithFlags(&ctx->e_pivot_done, hipEventDisableTiming), "create pivot event");
+    check_hip_error(hipEventCreateWithFlags(&ctx->e_row_done, hipEventDisableTiming), "create row event");
+    check_hip_error(hipEventCreateWithFlags(&ctx->e_col_done, hipEventDisableTiming), "create col event");
+    check_hip_error(hipEventCreateWithFlags(&ctx->e_p3_done, hipEventDisableTiming), "create phase3 event");
+    return *ctx;
+}
+
+static int* grow_device_buffer(int*& buf, size_t& cap, size_t bytes, const char* what) {
+    if (bytes > cap) {
+        if (buf) check_hip_error(hipFree(buf), what);
+        check_hip_error(hipMalloc(&buf, bytes), what);
+        cap = bytes;
+    }
+    return buf;
 }
 
 // Main GPU solver function
 void solve_apsp_gpu(int* dist, int V) {
-    int *d_dist = nullptr;
+    GpuContext& ctx = gpu_context();
     size_t bytes = size_t(V) * size_t(V) * sizeof(int);
-    check_hip_error(hipMalloc(&d_dist, bytes), "hipMalloc d_dist");
+    int *d_dist = grow_device_buffer(ctx.d_dist, ctx.dist_bytes, bytes, "hipMalloc d_dist");
     check_hip_error(hipMemcpy(d_dist, dist, bytes, hipMemcpyHostToDevice), "H2D dist");
 
     const int nB = (V + B - 1) / B;
     dim3 threads(B, B);
 
-    // Create independent streams for each phase to avoid default stream implicit sync
-    hipStream_t s_p1, s_row, s_col, s_p3;
-    check_hip_error(hipStreamCreate(&s_p1), "create phase1 stream");
-    check_hip_error(hipStreamCreate(&s_row), "create row stream");
-    check_hip_error(hipStreamCreate(&s_col), "create col stream");
-    check_hip_error(hipStreamCreate(&s_p3), "create phase3 stream");
-    
-    // Persistent events with timing disabled for better performance
-    hipEvent_t e_pivot_done, e_row_done, e_col_done, e_p3_done;
-    check_hip_error(hipEventCreateWithFlags(&e_pivot_done, hipEventDisableTiming), "create pivot event");
-    check_hip_error(hipEventCreateWithFlags(&e_row_done, hipEventDisableTiming), "create row event");
-    check_hip_error(hipEventCreateWithFlags(&e_col_done, hipEventDisableTiming), "create col event");
-    check_hip_error(hipEventCreateWithFlags(&e_p3_done, hipEventDisableTiming), "create phase3 event");
+    // Per-tile min summaries; every entry phase 3 reads is written by phase 2
+    // earlier in the same round, so no initialisation is needed
+    int *d_tile_min = grow_device_buffer(ctx.d_tile_min, ctx.tile_bytes,
+                                         size_t(nB) * nB * sizeof(int), "hipMalloc d_tile_min");
 
-    // Timing events (separate from synchronization events)
-    hipEvent_t e0, e1; 
-    check_hip_error(hipEventCreate(&e0), "create start event");
-    check_hip_error(hipEventCreate(&e1), "create end event");
-    check_hip_error(hipEventRecord(e0), "record start");
+    hipStream_t s_p1 = ctx.s_p1, s_row = ctx.s_row, s_col = ctx.s_col, s_p3 = ctx.s_p3;
+    hipEvent_t e_pivot_done = ctx.e_pivot_done, e_row_done = ctx.e_row_done;
+    hipEvent_t e_col_done = ctx.e_col_done, e_p3_done = ctx.e_p3_done;
 
     for (int kb = 0; kb < nB; ++kb) {
         // Wait for previous iteration's phase3 to complete (except first iteration)
@@ -341,9 +433,9 @@ void solve_apsp_gpu(int* dist, int V) {
         // Phase 1: Update pivot block - choose specialized version for full tiles
         const int pivot_size = (B < V - kb * B) ? B : (V - kb * B);
         if (pivot_size == B) {
-            fw_phase1_full<<<1, threads, 0, s_p1>>>(d_dist, V, kb);
+            hipLaunchKernelGGL(fw_phase1_full, 1, threads, 0, s_p1, d_dist, V, kb);
         } else {
-            fw_phase1<<<1, threads, 0, s_p1>>>(d_dist, V, kb);
+            hipLaunchKernelGGL(fw_phase1, 1, threads, 0, s_p1, d_dist, V, kb);
         }
         check_hip_error(hipGetLastError(), "phase1 kernel launch");
         check_hip_error(hipEventRecord(e_pivot_done, s_p1), "record pivot done");
@@ -354,16 +446,16 @@ void solve_apsp_gpu(int* dist, int V) {
         
         // Choose specialized version for full tiles in phase2 as well
         if (pivot_size == B) {
-            fw_phase2_row_full<<<nB, threads, 0, s_row>>>(d_dist, V, kb);
+            hipLaunchKernelGGL(fw_phase2_row_full, nB, threads, 0, s_row, d_dist, d_tile_min, V, kb);
             check_hip_error(hipGetLastError(), "phase2_row_full kernel launch");
             
-            fw_phase2_col_full<<<nB, threads, 0, s_col>>>(d_dist, V, kb);
+            hipLaunchKernelGGL(fw_phase2_col_full, nB, threads, 0, s_col, d_dist, d_tile_min, V, kb);
             check_hip_error(hipGetLastError(), "phase2_col_full kernel launch");
         } else {
-            fw_phase2_row<<<nB, threads, 0, s_row>>>(d_dist, V, kb);
+            hipLaunchKernelGGL(fw_phase2_row, nB, threads, 0, s_row, d_dist, d_tile_min, V, kb);
             check_hip_error(hipGetLastError(), "phase2_row kernel launch");
             
-            fw_phase2_col<<<nB, threads, 0, s_col>>>(d_dist, V, kb);
+            hipLaunchKernelGGL(fw_phase2_col, nB, threads, 0, s_col, d_dist, d_tile_min, V, kb);
             check_hip_error(hipGetLastError(), "phase2_col kernel launch");
         }
         
@@ -387,7 +479,7 @@ void solve_apsp_gpu(int* dist, int V) {
             if (pivot_full && fullBlocks >= 1) {
                 dim3 grid_full(fullBlocks - 1, fullBlocks - 1);
                 dim3 threads_full(B/2, B);     // 16×32=512 线程，匹配 micro-tiled kernel
-                fw_phase3_full_microtiled<<<grid_full, threads_full, 0, s_p3>>>(d_dist, V, kb);
+                hipLaunchKernelGGL(fw_phase3_full_microtiled, grid_full, threads_full, 0, s_p3, d_dist, d_tile_min, V, kb);
                 check_hip_error(hipGetLastError(), "phase3 full microtiled launch");
             }
 
@@ -396,7 +488,7 @@ void solve_apsp_gpu(int* dist, int V) {
             //    但在 kernel 内加一行"跳过内核区"的判断，避免重复计算。
             if (rem > 0 || !pivot_full) {
                 dim3 grid_edge(nB - 1, nB - 1);
-                fw_phase3<<<grid_edge, threads, 0, s_p3>>>(d_dist, V, kb);
+                hipLaunchKernelGGL(fw_phase3, grid_edge, threads, 0, s_p3, d_dist, d_tile_min, V, kb);
                 check_hip_error(hipGetLastError(), "phase3 edge launch");
             }
         }
@@ -406,71 +498,164 @@ void solve_apsp_gpu(int* dist, int V) {
 
     // Wait for final phase3 to complete
     check_hip_error(hipEventSynchronize(e_p3_done), "final sync");
-    
-    check_hip_error(hipEventRecord(e1), "record end");
-    check_hip_error(hipEventSynchronize(e1), "sync end");
-    float ms=0; 
-    check_hip_error(hipEventElapsedTime(&ms, e0, e1), "elapsed time");
-    fprintf(stderr, "[GPU] APSP elapsed = %.3f ms\n", ms);
 
     check_hip_error(hipMemcpy(dist, d_dist, bytes, hipMemcpyDeviceToHost), "D2H dist");
-    check_hip_error(hipFree(d_dist), "free d_dist");
-    
-    // Clean up streams and events
-    check_hip_error(hipStreamDestroy(s_p1), "destroy phase1 stream");
-    check_hip_error(hipStreamDestroy(s_row), "destroy row stream");
-    check_hip_error(hipStreamDestroy(s_col), "destroy col stream");
-    check_hip_error(hipStreamDestroy(s_p3), "destroy phase3 stream");
-    check_hip_error(hipEventDestroy(e_pivot_done), "destroy pivot event");
-    check_hip_error(hipEventDestroy(e_row_done), "destroy row event");
-    check_hip_error(hipEventDestroy(e_col_done), "destroy col event");
-    check_hip_error(hipEventDestroy(e_p3_done), "destroy phase3 event");
-    check_hip_error(hipEventDestroy(e0), "destroy start event");
-    check_hip_error(hipEventDestroy(e1), "destroy end event");
 }
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_file>" << std::endl;
-        return 1;
+// A loaded job: the distance matrix in solver labels, and new_id when the
+// vertices were relabelled
+struct ApspGraph {
+    int V = 0;
+    numa_alloc::vector<int> dist;
+    std::vector<int> new_id;
+};
+
+// args = {input_file} or {input_file, "--reorder"};
+// --reorder relabels vertices in Reverse Cuthill-McKee order at load time
+static bool load_graph(const std::vector<std::string>& args, ApspGraph& g, std::string& err) {
+    bool reorder = (args.size() == 2 && args[1] == "--reorder");
+    if (args.size() != 1 && !reorder) {
+        err = "Usage: <input_file> [--reorder]";
+        return false;
     }
-    
-    std::ifstream input(argv[1]);
+
+    std::ifstream input(args[0]);
     if (!input) {
-        std::cerr << "Error: Cannot open input file " << argv[1] << std::endl;
-        return 1;
+        err = "Error: Cannot open input file " + args[0];
+        return false;
     }
     
     int V, E;
     input >> V >> E;
+    g.V = V;
     
     // Allocate distance matrix
-    int* dist = new int[V * V];
+    g.dist.resize(size_t(V) * V);
+    int* dist = g.dist.data();
     
     // Initialize distance matrix
     initialize_distance_matrix(dist, V);
+    numa_alloc::report("dist", dist, g.dist.size() * sizeof(int));
     
-    // Read edges
-    for (int i = 0; i < E; i++) {
-        int src, dst, weight;
-        input >> src >> dst >> weight;
-        add_edge(dist, V, src, dst, weight);
+    if (reorder && (long long)E <= (long long)RCM_MAX_AVG_DEGREE * V) {
+        // Keep the edge list so the labels are known before the matrix is filled
+        std::vector<int> src(E), dst(E), weight(E);
+        for (int i = 0; i < E; i++) {
+            input >> src[i] >> dst[i] >> weight[i];
+        }
+        rcm_order(V, src, dst, g.new_id);
+        fprintf(stderr, "[GPU] RCM bandwidth %d -> %d\n",
+                edge_bandwidth(src, dst, {}), edge_bandwidth(src, dst, g.new_id));
+        for (int i = 0; i < E; i++) {
+            add_edge(dist, V, g.new_id[src[i]], g.new_id[dst[i]], weight[i]);
+        }
+    } else {
+        // Read edges
+        for (int i = 0; i < E; i++) {
+            int src, dst, weight;
+            input >> src >> dst >> weight;
+            add_edge(dist, V, src, dst, weight);
+        }
     }
     
     input.close();
-    
-    // Solve APSP on GPU
-    solve_apsp_gpu(dist, V);
-    
-    // Output result
+    return true;
+}
+
+// Solve APSP on GPU, split along strongly connected components. host_only
+// keeps every component on the calling thread (graphs the server already
+// solves concurrently on the host pool must not share the GPU context).
+static void solve_graph(ApspGraph& g, bool host_only = false) {
+    if (host_only) {
+        solve_apsp_scc(g.dist.data(), g.V, floyd_warshall_host, floyd_warshall_host, INT_MAX);
+        return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    solve_apsp_scc(g.dist.data(), g.V, floyd_warshall_host, solve_apsp_gpu, SCC_GPU_MIN_VERTICES);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    fprintf(stderr, "[GPU] APSP elapsed = %.3f ms\n", ms);
+}
+
+// Output result, undoing the relabelling if one was applied
+static bool write_graph(const ApspGraph& g, int out_fd) {
+    const int V = g.V;
+    const std::vector<int>& new_id = g.new_id;
+    std::string buf;
+    buf.reserve(1 << 20);
+    char tmp[16];
     for (int i = 0; i < V; i++) {
+        const int* row = g.dist.data() + (size_t)(new_id.empty() ? i : new_id[i]) * V;
         for (int j = 0; j < V; j++) {
-            std::cout << dist[i * V + j];
-            if (j < V - 1) std::cout << " ";
+            char* end = std::to_chars(tmp, tmp + sizeof(tmp), row[new_id.empty() ? j : new_id[j]]).ptr;
+            if (j < V - 1) *end++ = ' ';
+            buf.append(tmp, end);
+        }
+        buf += '\n';
+        if (buf.size() >= (1 << 20)) {
+            if (!fd_io::write_all(out_fd, buf)) return false;
+            buf.clear();
         }
-        std::cout << std::endl;
     }
-    
-    delete[] dist;
+    return fd_io::write_all(out_fd, buf);
+}
+
+static bool run_job(const std::vector<std::string>& args, int out_fd, std::string& err) {
+    ApspGraph g;
+    if (!load_graph(args, g, err)) return false;
+    solve_graph(g);
+    if (!write_graph(g, out_fd)) {
+        err = "write failed";
+        return false;
+    }
+    return true;
+}
+
+// Server batch: graphs too small for the GPU are solved concurrently on the
+// host pool; the rest go through the GPU one at a time
+static void serve_batch(std::vector<solver_server::Job>& batch) {
+    std::vector<solver_server::Job*> small_jobs;
+    std::vector<ApspGraph> small;
+    for (solver_server::Job& job : batch) {
+        ApspGraph g;
+        if (!load_graph(job.args, g, job.error)) continue;
+        if (g.V < SCC_GPU_MIN_VERTICES) {
+            small.push_back(std::move(g));
+            small_jobs.push_back(&job);
+            continue;
+        }
+        solve_graph(g);
+        if (!write_graph(g, job.out_fd)) job.error = "write failed";
+    }
+
+    // The pool is busy with this loop, so the nested parallel_for_ranges in
+    // solve_apsp_scc runs single-threaded on each worker: the batch uses at
+    // most host_thread_count() threads
+    parallel_for_ranges(small.size(), [&](size_t b, size_t e, int) {
+        for (size_t i = b; i < e; i++) solve_graph(small[i], true);
+    });
+    for (size_t i = 0; i < small.size(); i++) {
+        if (!write_graph(small[i], small_jobs[i]->out_fd)) small_jobs[i]->error = "write failed";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--serve") {
+        return solver_server::serve(argv[2], "apsp", serve_batch);
+    }
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <input_file> [--reorder]" << std::endl;
+        std::cerr << "       " << argv[0] << " --serve <socket>" << std::endl;
+        return 1;
+    }
+
+    std::string err;
+    if (!run_job(std::vector<std::string>(argv + 1, argv + argc), STDOUT_FILENO, err)) {
+        if (err.compare(0, 6, "Usage:") == 0) {
+            std::cerr << "Usage: " << argv[0] << " <input_file> [--reorder]" << std::endl;
+        } else {
+            std::cerr << err << std::endl;
+        }
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -17,12 +17,12 @@
 // GPU kernel declarations for optimized blocked Floyd-Warshall
 __global__ void fw_phase1(int* __restrict__ dist, int V, int kb);
 __global__ void fw_phase1_full(int* __restrict__ dist, int V, int kb);
-__global__ void fw_phase2_row(int* __restrict__ dist, int V, int kb);
-__global__ void fw_phase2_row_full(int* __restrict__ dist, int V, int kb);
-__global__ void fw_phase2_col(int* __restrict__ dist, int V, int kb);
-__global__ void fw_phase2_col_full(int* __restrict__ dist, int V, int kb);
-__global__ void fw_phase3(int* __restrict__ dist, int V, int kb);
-__global__ void fw_phase3_full_microtiled(int* __restrict__ dist, int V, int kb);
+__global__ void fw_phase2_row(int* __restrict__ dist, int* __restrict__ tile_min, int V, int kb);
+__global__ void fw_phase2_row_full(int* __restrict__ dist, int* __restrict__ tile_min, int V, int kb);
+__global__ void fw_phase2_col(int* __restrict__ dist, int* __restrict__ tile_min, int V, int kb);
+__global__ void fw_phase2_col_full(int* __restrict__ dist, int* __restrict__ tile_min, int V, int kb);
+__global__ void fw_phase3(int* __restrict__ dist, const int* __restrict__ tile_min, int V, int kb);
+__global__ void fw_phase3_full_microtiled(int* __restrict__ dist, const int* __restrict__ tile_min, int V, int kb);
 
 // Helper functions
 void check_hip_error(hipError_t err, const char* msg);
@@ -1,15 +1,15 @@
 #include "main_serial.h"
+#include "scc_prepass.h"
+#include "../common/numa_alloc.h"
 
-// Initialize distance matrix with INF and 0 on diagonal
+// Initialize distance matrix with INF and 0 on diagonal. The serial
+// reference stays single-threaded, so its pages stay on the node of the one
+// thread that solves; main.cpp splits this fill across the host pool.
 void initialize_distance_matrix(int* dist, int V) {
-    for (int i = 0; i < V; i++) {
-        for (int j = 0; j < V; j++) {
-            if (i == j) {
-                dist[i * V + j] = 0;
-            } else {
-                dist[i * V + j] = INF;
-            }
-        }
+    for (size_t i = 0; i < (size_t)V; i++) {
+        int* row = dist + i * V;
+        std::fill(row, row + V, INF);
+        row[i] = 0;
     }
 }
 
@@ -53,11 +53,13 @@ int main(int argc, char* argv[]) {
     int V, E;
     input >> V >> E;
     
-    // Allocate distance matrix
-    int* dist = new int[V * V];
+    // Allocate distance matrix (mmap-backed, HPC_HUGEPAGES applies)
+    numa_alloc::vector<int> matrix((size_t)V * V);
+    int* dist = matrix.data();
     
     // Initialize distance matrix
     initialize_distance_matrix(dist, V);
+    numa_alloc::report("dist", dist, matrix.size() * sizeof(int));
     
     // Read edges
     for (int i = 0; i < E; i++) {
@@ -68,8 +70,9 @@ int main(int argc, char* argv[]) {
     
     input.close();
     
-    // Solve APSP using serial algorithm
-    solve_apsp_serial(dist, V);
+    // Solve APSP using serial algorithm; the SCC pre-pass splits graphs that
+    // are not strongly connected into independent per-component solves
+    solve_apsp_scc(dist, V, solve_apsp_serial, solve_apsp_serial, INT_MAX);
     
     // Output result
     for (int i = 0; i < V; i++) {
@@ -80,6 +83,5 @@ int main(int argc, char* argv[]) {
         std::cout << std::endl;
     }
     
-    delete[] dist;
     return 0;
 }
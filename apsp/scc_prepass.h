@@ -0,0 +1,286 @@
+#ifndef SCC_PREPASS_H
+#define SCC_PREPASS_H
+
+// Strongly-connected-component pre-pass for APSP.
+//
+// Vertices in different SCCs can only be joined along the condensation DAG,
+// so the V^3 solve splits into:
+//   1. Tarjan's algorithm over the adjacency implied by the distance matrix;
+//      components come out numbered sinks-first (reverse topological order).
+//   2. An independent dense APSP inside every component, run in parallel.
+//   3. A min-plus combine per component A in topological order from the sinks:
+//        U[u][t]  = min over edges (a,t) leaving A of  D[u][a] + w(a,t)
+//        D[u][x]  = min over exit targets t        of  U[u][t] + D[t][x]
+//      restricted to the columns some exit target can reach. Components of
+//      the same DAG level do not depend on each other and run in parallel.
+// Entries between components with no path stay INF, so the full matrix
+// output is unchanged.
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+#include "../common/parallel.h"
+
+#ifndef INF
+#define INF 1073741823  // 2^30 - 1
+#endif
+
+// Below this many vertices the whole matrix is solved directly
+#define SCC_MIN_VERTICES 64
+
+// Reference dense Floyd-Warshall used for small components
+inline void floyd_warshall_host(int* dist, int n) {
+    for (int k = 0; k < n; k++) {
+        const int* row_k = dist + (size_t)k * n;
+        for (int i = 0; i < n; i++) {
+            int* row_i = dist + (size_t)i * n;
+            const int dik = row_i[k];
+            if (dik >= INF) continue;
+            for (int j = 0; j < n; j++) {
+                int via = dik + row_k[j];
+                if (row_k[j] < INF && via < row_i[j]) row_i[j] = via;
+            }
+        }
+    }
+}
+
+// Iterative Tarjan over the matrix (edge u->v iff dist[u][v] < INF, u != v).
+// Returns the number of components; comp[v] is numbered sinks-first.
+inline int tarjan_scc(const int* dist, int V, std::vector<int>& comp) {
+    std::vector<int> index(V, -1), low(V, 0), next(V, 0), stack, call;
+    std::vector<char> on_stack(V, 0);
+    stack.reserve(V);
+    call.reserve(V);
+    comp.assign(V, -1);
+    int counter = 0, ncomp = 0;
+
+    for (int s = 0; s < V; s++) {
+        if (index[s] != -1) continue;
+        index[s] = low[s] = counter++;
+        stack.push_back(s);
+        on_stack[s] = 1;
+        call.push_back(s);
+
+        while (!call.empty()) {
+            const int v = call.back();
+            const int* row = dist + (size_t)v * V;
+            int w = next[v];
+            while (w < V && (w == v || row[w] >= INF)) w++;
+            if (w < V) {
+                next[v] = w + 1;
+                if (index[w] == -1) {
+                    index[w] = low[w] = counter++;
+                    stack.push_back(w);
+                    on_stack[w] = 1;
+                    call.push_back(w);
+                } else if (on_stack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            next[v] = V;
+            call.pop_back();
+            if (!call.empty()) low[call.back()] = std::min(low[call.back()], low[v]);
+            if (low[v] == index[v]) {
+                int x;
+                do {
+                    x = stack.back();
+                    stack.pop_back();
+                    on_stack[x] = 0;
+                    comp[x] = ncomp;
+                } while (x != v);
+                ncomp++;
+            }
+        }
+    }
+    return ncomp;
+}
+
+// Edges leaving one component and the columns they can reach
+struct SccExitPlan {
+    std::vector<int> targets;                       // distinct exit targets t
+    std::vector<int> cols;                          // columns reachable from some t
+    std::vector<int> target_col;                    // index of targets[s] in cols
+    std::vector<int> edge_from, edge_slot, edge_w;  // leaving edges (a, t, w)
+};
+
+inline void scc_build_exit_plan(const int* dist, int V, const std::vector<int>& comp,
+                                const std::vector<int>& members, SccExitPlan& plan) {
+    const int c = comp[members[0]];
+    std::vector<int> slot;
+    for (int a : members) {
+        const int* row = dist + (size_t)a * V;
+        for (int t = 0; t < V; t++) {
+            if (row[t] >= INF || comp[t] == c) continue;
+            if (slot.empty()) slot.assign(V, -1);
+            if (slot[t] < 0) {
+                slot[t] = (int)plan.targets.size();
+                plan.targets.push_back(t);
+            }
+            plan.edge_from.push_back(a);
+            plan.edge_slot.push_back(slot[t]);
+            plan.edge_w.push_back(row[t]);
+        }
+    }
+    if (plan.targets.empty()) return;
+
+    std::vector<char> reach(V, 0);
+    for (int t : plan.targets) {
+        const int* row = dist + (size_t)t * V;
+        for (int x = 0; x < V; x++) reach[x] |= (row[x] < INF);
+    }
+    std::vector<int> col_of(V, -1);
+    for (int x = 0; x < V; x++) {
+        if (reach[x] && comp[x] != c) {
+            col_of[x] = (int)plan.cols.size();
+            plan.cols.push_back(x);
+        }
+    }
+    for (int t : plan.targets) {
+        if (col_of[t] < 0) {
+            col_of[t] = (int)plan.cols.size();
+            plan.cols.push_back(t);
+        }
+        plan.target_col.push_back(col_of[t]);
+    }
+}
+
+// Min-plus combine for rows [row_begin, row_end) of a component's member
+// list. Only the rows' cross-component columns are written, and the leaving
+// edge weights come from the plan, so row ranges may run concurrently.
+// The empty path u->u and t->t counts as 0: the stored diagonal may hold a
+// self-loop weight, which no shortest path to another vertex ever uses.
+inline void scc_combine_rows(int* dist, int V, const std::vector<int>& members,
+                             const SccExitPlan& plan, size_t row_begin, size_t row_end) {
+    const size_t nt = plan.targets.size();
+    const size_t ne = plan.edge_from.size();
+    const size_t nc = plan.cols.size();
+    std::vector<int> u_row(nt), best(nc);
+
+    for (size_t r = row_begin; r < row_end; r++) {
+        int* row_u = dist + (size_t)members[r] * V;
+
+        std::fill(u_row.begin(), u_row.end(), INF);
+        for (size_t e = 0; e < ne; e++) {
+            const int a = plan.edge_from[e];
+            const int dua = (a == members[r]) ? 0 : row_u[a];
+            if (dua >= INF) continue;
+            const int via = dua + plan.edge_w[e];
+            if (via < u_row[plan.edge_slot[e]]) u_row[plan.edge_slot[e]] = via;
+        }
+
+        for (size_t k = 0; k < nc; k++) best[k] = row_u[plan.cols[k]];
+        for (size_t s = 0; s < nt; s++) {
+            const int ut = u_row[s];
+            if (ut >= INF) continue;
+            const int* row_t = dist + (size_t)plan.targets[s] * V;
+            for (size_t k = 0; k < nc; k++) {
+                const int d = row_t[plan.cols[k]];
+                if (d < INF && ut + d < best[k]) best[k] = ut + d;
+            }
+            const int kt = plan.target_col[s];
+            if (ut < best[kt]) best[kt] = ut;
+        }
+        for (size_t k = 0; k < nc; k++) row_u[plan.cols[k]] = best[k];
+    }
+}
+
+// APSP with the SCC pre-pass. host_solver(block, n) solves a compacted
+// component in place and may run concurrently on several host threads;
+// components of at least large_min vertices go to large_solver one at a
+// time from host pool task 0 (e.g. the GPU solver). A strongly connected
+// graph, or one below SCC_MIN_VERTICES, goes to large_solver whole, exactly
+// as without the pre-pass.
+template <typename HostSolver, typename LargeSolver>
+void solve_apsp_scc(int* dist, int V, HostSolver host_solver, LargeSolver large_solver,
+                    int large_min) {
+    std::vector<int> comp;
+    const int ncomp = (V < SCC_MIN_VERTICES) ? 1 : tarjan_scc(dist, V, comp);
+    if (ncomp == 1) {
+        large_solver(dist, V);
+        return;
+    }
+
+    std::vector<std::vector<int>> members(ncomp);
+    for (int v = 0; v < V; v++) members[comp[v]].push_back(v);
+
+    // Dense solve inside every component; blocks are compacted into scratch
+    auto solve_component = [&](int c, bool large) {
+        const std::vector<int>& m = members[c];
+        const int n = (int)m.size();
+        std::vector<int> block((size_t)n * n);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++) block[(size_t)i * n + j] = dist[(size_t)m[i] * V + m[j]];
+        if (large) large_solver(block.data(), n);
+        else host_solver(block.data(), n);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++) dist[(size_t)m[i] * V + m[j]] = block[(size_t)i * n + j];
+    };
+
+    std::vector<int> small, large;
+    for (int c = 0; c < ncomp; c++) {
+        if ((int)members[c].size() >= large_min) large.push_back(c);
+        else if (members[c].size() > 1) small.push_back(c);
+    }
+    // Largest first so one big component does not end up last on a worker
+    std::sort(small.begin(), small.end(), [&](int a, int b) {
+        return members[a].size() > members[b].size();
+    });
+
+    // One pool task per worker: task 0 first feeds the large components to
+    // large_solver, then every task drains the small ones. Inside another
+    // parallel loop (e.g. the server solving several small graphs at once)
+    // the tasks run one after another on the calling thread.
+    std::atomic<size_t> next_small(0);
+    const size_t tasks = std::min<size_t>(host_thread_count(), small.size() + (large.empty() ? 0 : 1));
+    parallel_for_ranges(tasks, [&](size_t, size_t, int w) {
+        if (w == 0) {
+            for (int c : large) solve_component(c, true);
+        }
+        for (size_t i = next_small++; i < small.size(); i = next_small++) solve_component(small[i], false);
+    });
+
+    // DAG level of every component, sinks at level 0. Components are
+    // numbered sinks-first, so successors are final when a component is visited.
+    std::vector<int> level(ncomp, 0);
+    int max_level = 0;
+    for (int c = 0; c < ncomp; c++) {
+        for (int u : members[c]) {
+            const int* row = dist + (size_t)u * V;
+            for (int x = 0; x < V; x++) {
+                if (row[x] < INF && comp[x] != c) level[c] = std::max(level[c], level[comp[x]] + 1);
+            }
+        }
+        max_level = std::max(max_level, level[c]);
+    }
+    std::vector<std::vector<int>> by_level(max_level + 1);
+    for (int c = 0; c < ncomp; c++) by_level[level[c]].push_back(c);
+
+    for (int l = 1; l <= max_level; l++) {
+        const std::vector<int>& cs = by_level[l];
+        if (cs.size() == 1) {
+            // A lone component on its level splits its rows across workers
+            const std::vector<int>& m = members[cs[0]];
+            SccExitPlan plan;
+            scc_build_exit_plan(dist, V, comp, m, plan);
+            parallel_for_ranges(m.size(), [&](size_t b, size_t e, int) {
+                scc_combine_rows(dist, V, m, plan, b, e);
+            });
+        } else {
+            parallel_for_ranges(cs.size(), [&](size_t b, size_t e, int) {
+                for (size_t i = b; i < e; i++) {
+                    const std::vector<int>& m = members[cs[i]];
+                    SccExitPlan plan;
+                    scc_build_exit_plan(dist, V, comp, m, plan);
+                    scc_combine_rows(dist, V, m, plan, 0, m.size());
+                }
+            });
+        }
+    }
+}
+
+#endif
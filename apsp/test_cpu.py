@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# CPU 后端回归测试：用 common/hip_cpu 编译出的 main_cpu（默认与 --reorder 各一次）
+# 与串行基线 main_serial 在随机图上比较，输出要求逐字节一致。图的规模覆盖不满
+# 一个 tile、整体强连通（整图交给 GPU 求解器）、大分量走 GPU 而小分量走主机的
+# SCC 预处理路径，以及阶段 3 瓦片跳过必然触发的分簇环。
+#
+# 用法: python3 test_cpu.py ./main_serial ./main_cpu
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+# (V, 分组数, 每点平均出边数)；分组数为 1 时加一个环保证强连通
+CASES = [
+    (2, 1, 1),
+    (33, 1, 4),
+    (100, 1, 6),
+    (200, 6, 5),
+    (600, 1, 3),
+    (800, 4, 6),
+]
+
+
+def make_graph(rng, V, groups, degree):
+    # 组间只有从小组号到大组号的边，于是每组各成一个或多个分量；
+    # 0 号组占 3/4 的顶点，V 足够大时成为交给 GPU 求解器的大分量
+    big = V * 3 // 4 if groups > 1 else V
+    owner = [0] * big + sorted(rng.randrange(1, groups) for _ in range(V - big))
+    edges = {}
+    if groups == 1 and V > 1:
+        for v in range(V):
+            edges[(v, (v + 1) % V)] = rng.randint(0, 1000)
+    for _ in range(V * degree):
+        s, d = rng.randrange(V), rng.randrange(V)
+        if s != d and owner[s] <= owner[d]:
+            edges[(s, d)] = rng.randint(0, 1000)
+    return edges
+
+
+# 分簇环：每簇 32 个顶点（与 32×32 瓦片对齐），簇内稠密、权值小，只有第 c 簇
+# 指向第 c+1 簇（末簇回到首簇）的少量重边。整图强连通，整体交给 GPU 求解器；
+# 第 kb 轮开始时，只有已经能经 kb 之前的簇到达或来自这些簇的瓦片有限，
+# 其余行/列瓦片的 tile_min 为 INF，阶段 3 必然整块跳过；簇内短路径又使
+# 很多线程的当前值不大于下界，触发逐线程跳过。V 取非 32 的倍数以包含不完整瓦片。
+RING_V, RING_TILE = 650, 32
+
+
+def make_ring(rng):
+    V, T = RING_V, RING_TILE
+    nc = (V + T - 1) // T
+    edges = {}
+    for c in range(nc):
+        members = list(range(c * T, min(V, (c + 1) * T)))
+        for s in members:
+            for _ in range(4):
+                d = rng.choice(members)
+                if d != s:
+                    edges[(s, d)] = rng.randint(0, 10)
+        nxt = list(range(((c + 1) % nc) * T, min(V, ((c + 1) % nc + 1) * T)))
+        for _ in range(2):
+            edges[(rng.choice(members), rng.choice(nxt))] = rng.randint(500, 1000)
+    return edges
+
+
+def inf_tiles(V, edges, T=RING_TILE):
+    """Tiles with no finite entry in the input (off the diagonal)."""
+    nb = (V + T - 1) // T
+    finite = {(s // T, t // T) for (s, t) in edges} | {(b, b) for b in range(nb)}
+    return nb * nb - len(finite)
+
+
+def run(binary, path, opts=()):
+    return subprocess.run([binary, path] + list(opts), stdout=subprocess.PIPE,
+                          stderr=subprocess.DEVNULL, check=True).stdout
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("usage: test_cpu.py <serial_binary> <cpu_binary>")
+        return 2
+    serial, cpu = sys.argv[1], sys.argv[2]
+    rng = random.Random(2024)
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "g.in")
+        graphs = [("V=%d groups=%d" % (V, groups), V, make_graph(rng, V, groups, degree))
+                  for V, groups, degree in CASES]
+        ring = make_ring(rng)
+        # 至少九成瓦片初始全为 INF，保证阶段 3 的瓦片跳过确实被执行
+        assert inf_tiles(RING_V, ring) * 10 >= 9 * ((RING_V + RING_TILE - 1) // RING_TILE) ** 2
+        graphs.append(("clustered ring V=%d" % RING_V, RING_V, ring))
+        for name, V, edges in graphs:
+            with open(path, "w") as f:
+                f.write("%d %d\n" % (V, len(edges)))
+                for (s, t), w in edges.items():
+                    f.write("%d %d %d\n" % (s, t, w))
+            ref = run(serial, path).split()
+            # --reorder 只改变内部编号，输出必须与串行基线一致
+            for opts in ([], ["--reorder"]):
+                got = run(cpu, path, opts).split()
+                if ref != got:
+                    failed += 1
+                    i = next((i for i, (x, y) in enumerate(zip(ref, got)) if x != y), min(len(ref), len(got)))
+                    print("FAIL %s %s: first difference at [%d][%d]"
+                          % (name, " ".join(opts), i // V, i % V))
+    print("test_cpu: %s" % ("FAIL" if failed else "PASS"))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+# SCC 预处理回归测试：随机生成含多个强连通分量与自环的小图，
+# 将被测程序的输出与朴素 Floyd-Warshall（与 main_serial 基线语义一致）逐项比较。
+#
+# 用法: python3 test_scc.py ./main_serial [./main_cpu ...]
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+INF = 1073741823
+
+
+def make_graph(seed):
+    rng = random.Random(seed)
+    V = rng.choice([64, 70, 96])
+    edges = {}
+    # 若干稠密小团（各自成为强连通分量），团之间只有单向边
+    groups = rng.randint(3, 8)
+    owner = [rng.randrange(groups) for _ in range(V)]
+    for _ in range(V * 3):
+        s, d = rng.randrange(V), rng.randrange(V)
+        if s == d:
+            continue
+        if owner[s] == owner[d] or owner[s] < owner[d]:
+            edges[(s, d)] = rng.randint(0, 100)
+    # 自环：输入约束之外，但基线实现会把权值写到对角线上
+    for _ in range(rng.randint(1, 6)):
+        v = rng.randrange(V)
+        edges[(v, v)] = rng.randint(1, 100)
+    return V, edges
+
+
+def reference(V, edges):
+    d = [[INF] * V for _ in range(V)]
+    for i in range(V):
+        d[i][i] = 0
+    for (s, t), w in edges.items():
+        d[s][t] = w
+    for k in range(V):
+        dk = d[k]
+        for i in range(V):
+            dik = d[i][k]
+            if dik == INF:
+                continue
+            di = d[i]
+            for j in range(V):
+                if dk[j] != INF and dik + dk[j] < di[j]:
+                    di[j] = dik + dk[j]
+    return d
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: test_scc.py <binary> [<binary> ...]")
+        return 2
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "g.in")
+        for seed in range(32):
+            V, edges = make_graph(seed)
+            with open(path, "w") as f:
+                f.write("%d %d\n" % (V, len(edges)))
+                for (s, t), w in edges.items():
+                    f.write("%d %d %d\n" % (s, t, w))
+            expect = reference(V, edges)
+            for binary in sys.argv[1:]:
+                out = subprocess.run([binary, path], stdout=subprocess.PIPE,
+                                     stderr=subprocess.DEVNULL, check=True).stdout.split()
+                got = [int(x) for x in out]
+                bad = [(i, j) for i in range(V) for j in range(V) if got[i * V + j] != expect[i][j]]
+                if len(got) != V * V or bad:
+                    failed += 1
+                    i, j = bad[0] if bad else (0, 0)
+                    print("FAIL %s seed=%d V=%d [%d][%d]: got %d, expected %d"
+                          % (binary, seed, V, i, j, got[i * V + j], expect[i][j]))
+    print("test_scc: %s" % ("FAIL" if failed else "PASS"))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
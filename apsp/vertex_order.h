@@ -0,0 +1,84 @@
+#ifndef VERTEX_ORDER_H
+#define VERTEX_ORDER_H
+
+// Bandwidth-reducing vertex relabelling for the blocked Floyd-Warshall.
+//
+// Reverse Cuthill-McKee on the symmetrised edge list places vertices that
+// reach each other next to each other, so non-INF entries cluster into few
+// B x B tiles around the diagonal and phase 3 can skip the rest through the
+// tile summaries. Edges are relabelled at load time and the output is
+// printed through the inverse mapping, so the result is unchanged.
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+// Above this average degree the matrix is dense enough that reordering
+// cannot create empty tiles, and the edge list is not worth keeping
+#define RCM_MAX_AVG_DEGREE 64
+
+// new_id[v] is the RCM label of vertex v
+inline void rcm_order(int V, const std::vector<int>& src, const std::vector<int>& dst,
+                      std::vector<int>& new_id) {
+    std::vector<int> deg(V, 0);
+    for (size_t e = 0; e < src.size(); e++) {
+        deg[src[e]]++;
+        deg[dst[e]]++;
+    }
+    std::vector<long long> start(V + 1, 0);
+    for (int v = 0; v < V; v++) start[v + 1] = start[v] + deg[v];
+    std::vector<int> adj(start[V]);
+    std::vector<long long> fill(start.begin(), start.end() - 1);
+    for (size_t e = 0; e < src.size(); e++) {
+        adj[fill[src[e]]++] = dst[e];
+        adj[fill[dst[e]]++] = src[e];
+    }
+
+    // BFS from the lowest-degree unvisited vertex of every connected
+    // component, visiting neighbours in increasing degree order
+    std::vector<int> by_degree(V);
+    for (int v = 0; v < V; v++) by_degree[v] = v;
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&](int a, int b) { return deg[a] < deg[b]; });
+
+    std::vector<int> order;
+    order.reserve(V);
+    std::vector<char> visited(V, 0);
+    std::vector<int> nbrs;
+    for (int s : by_degree) {
+        if (visited[s]) continue;
+        visited[s] = 1;
+        size_t head = order.size();
+        order.push_back(s);
+        while (head < order.size()) {
+            const int v = order[head++];
+            nbrs.clear();
+            for (long long e = start[v]; e < start[v + 1]; e++) {
+                if (!visited[adj[e]]) {
+                    visited[adj[e]] = 1;
+                    nbrs.push_back(adj[e]);
+                }
+            }
+            std::sort(nbrs.begin(), nbrs.end(), [&](int a, int b) {
+                return deg[a] < deg[b] || (deg[a] == deg[b] && a < b);
+            });
+            order.insert(order.end(), nbrs.begin(), nbrs.end());
+        }
+    }
+
+    new_id.resize(V);
+    for (int k = 0; k < V; k++) new_id[order[k]] = V - 1 - k;
+}
+
+// Largest |new_id[src] - new_id[dst]| over the edges (identity if new_id is empty)
+inline int edge_bandwidth(const std::vector<int>& src, const std::vector<int>& dst,
+                          const std::vector<int>& new_id) {
+    int bw = 0;
+    for (size_t e = 0; e < src.size(); e++) {
+        int a = new_id.empty() ? src[e] : new_id[src[e]];
+        int b = new_id.empty() ? dst[e] : new_id[dst[e]];
+        bw = std::max(bw, std::abs(a - b));
+    }
+    return bw;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef COMMON_FD_IO_H
+#define COMMON_FD_IO_H
+
+// Result output shared by the command-line tools and the solver server.
+//
+// write_all() works on blocking descriptors (stdout, --output files) and on
+// the server's non-blocking client sockets. On a socket that accepts no data
+// for FD_IO_STALL_TIMEOUT_MS it gives up and shuts the connection down, so a
+// client that stops reading its reply fails its own job instead of blocking
+// the thread that writes, and later writes to it fail at once.
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define FD_IO_STALL_TIMEOUT_MS 2000
+
+namespace fd_io {
+
+inline bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            pollfd pfd = {fd, POLLOUT, 0};
+            int ready = ::poll(&pfd, 1, FD_IO_STALL_TIMEOUT_MS);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0 || (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) {
+                ::shutdown(fd, SHUT_RDWR);
+                return false;
+            }
+            continue;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+inline bool write_all(int fd, const std::string& text) {
+    return write_all(fd, text.data(), text.size());
+}
+
+}  // namespace fd_io
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef HIP_CPU_HIP_RUNTIME_H
+#define HIP_CPU_HIP_RUNTIME_H
+
+// Stand-in for <hip/hip_runtime.h> when building with the CPU backend
+// (-I common/hip_cpu). See hip_cpu_runtime.h.
+#include "../hip_cpu_runtime.h"
+
+#endif
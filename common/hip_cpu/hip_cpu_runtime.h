@@ -0,0 +1,630 @@
+#ifndef HIP_CPU_RUNTIME_H
+#define HIP_CPU_RUNTIME_H
+
+// CPU execution backend for the HIP subset used in this repository.
+//
+// Kernels compile unchanged with g++: every workgroup runs on one worker
+// thread of a persistent pool, and every work-item of the workgroup is a
+// fiber on that thread. __syncthreads() and the __shfl_* family are
+// cooperative yields, so workgroups never block a worker and all cores stay
+// busy. __shared__ variables become thread_local, which is per-workgroup
+// because a worker runs exactly one workgroup at a time. Dynamic shared
+// memory must be declared as HIP_DYNAMIC_SHARED(type, name); which HIP also
+// provides, since `extern __shared__ type name[];` has no CPU equivalent.
+//
+// Memory is host memory, copies are memcpy, streams are in-order and every
+// launch completes before returning, so events only record timestamps.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <sys/mman.h>
+
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Qualifiers
+// ---------------------------------------------------------------------------
+#define __global__
+#define __device__
+#define __host__
+#define __constant__
+#define __forceinline__ inline __attribute__((always_inline))
+#define __launch_bounds__(...)
+#define __shared__ thread_local
+#define HIP_DYNAMIC_SHARED(type, var) \
+    type* var = reinterpret_cast<type*>(::hip_cpu::detail::dynamic_shared())
+
+struct dim3 {
+    uint32_t x, y, z;
+    constexpr dim3(uint32_t _x = 1, uint32_t _y = 1, uint32_t _z = 1) : x(_x), y(_y), z(_z) {}
+};
+
+static constexpr int warpSize = 64;
+
+// Device-side min/max as HIP declares them: one overload per arithmetic
+// type, so mixed-type calls fail to compile here just as they do on the GPU
+#define HIP_CPU_MIN_MAX(T) \
+    __device__ __host__ inline T min(T a, T b) { return b < a ? b : a; } \
+    __device__ __host__ inline T max(T a, T b) { return a < b ? b : a; }
+HIP_CPU_MIN_MAX(int)
+HIP_CPU_MIN_MAX(unsigned int)
+HIP_CPU_MIN_MAX(long)
+HIP_CPU_MIN_MAX(unsigned long)
+HIP_CPU_MIN_MAX(long long)
+HIP_CPU_MIN_MAX(unsigned long long)
+HIP_CPU_MIN_MAX(float)
+HIP_CPU_MIN_MAX(double)
+#undef HIP_CPU_MIN_MAX
+
+// ---------------------------------------------------------------------------
+// Runtime types
+// ---------------------------------------------------------------------------
+typedef enum hipError_t {
+    hipSuccess = 0,
+    hipErrorInvalidValue = 1,
+    hipErrorOutOfMemory = 2,
+} hipError_t;
+
+typedef enum hipMemcpyKind {
+    hipMemcpyHostToHost = 0,
+    hipMemcpyHostToDevice = 1,
+    hipMemcpyDeviceToHost = 2,
+    hipMemcpyDeviceToDevice = 3,
+    hipMemcpyDefault = 4,
+} hipMemcpyKind;
+
+typedef struct ihipStream_t* hipStream_t;
+struct ihipEvent_t {
+    std::chrono::steady_clock::time_point stamp;
+};
+typedef ihipEvent_t* hipEvent_t;
+
+#define hipEventDefault 0x0
+#define hipEventDisableTiming 0x2
+#define hipStreamDefault 0x0
+#define hipStreamNonBlocking 0x1
+
+namespace hip_cpu {
+namespace detail {
+
+// ---------------------------------------------------------------------------
+// Fibers
+// ---------------------------------------------------------------------------
+static constexpr size_t kFiberStack = 64 * 1024;
+static constexpr int kMaxBlockThreads = 1024;
+
+struct Block;
+
+struct Fiber {
+#if defined(__x86_64__)
+    void* sp = nullptr;
+#else
+    ucontext_t ctx;
+#endif
+    dim3 tid;
+    int linear = 0;
+    bool done = false;
+    char* stack = nullptr;
+};
+
+struct Barrier {
+    int arrived = 0;
+    int live = 0;
+    unsigned gen = 0;
+};
+
+struct Block {
+    dim3 idx;
+    dim3 dim;
+    dim3 grid;
+    std::function<void()>* body = nullptr;
+    Barrier block_bar;
+    std::vector<Barrier> warp_bar;
+    std::vector<uint64_t> lanes;   // __shfl exchange slots, one per work-item
+};
+
+struct Worker {
+    std::vector<Fiber> fibers;
+    char* stacks = nullptr;
+    size_t stacks_count = 0;
+    Block block;
+    Fiber* current = nullptr;
+#if defined(__x86_64__)
+    void* sched_sp = nullptr;
+#else
+    ucontext_t sched_ctx;
+#endif
+    std::vector<char> shared;
+};
+
+inline Worker& worker() {
+    static thread_local Worker w;
+    return w;
+}
+
+inline void* dynamic_shared() {
+    return worker().shared.data();
+}
+
+inline const dim3& thread_idx() { return worker().current->tid; }
+inline const dim3& block_idx() { return worker().block.idx; }
+inline const dim3& block_dim() { return worker().block.dim; }
+inline const dim3& grid_dim() { return worker().block.grid; }
+
+#if defined(__x86_64__)
+// Saves callee-saved registers on the current stack, stores the stack pointer
+// into *save and resumes the context whose stack pointer is `next`.
+__attribute__((naked, noinline)) static void ctx_switch(void** /*save*/, void* /*next*/) {
+    __asm__ volatile(
+        "pushq %rbp\n\t"
+        "pushq %rbx\n\t"
+        "pushq %r12\n\t"
+        "pushq %r13\n\t"
+        "pushq %r14\n\t"
+        "pushq %r15\n\t"
+        "movq %rsp, (%rdi)\n\t"
+        "movq %rsi, %rsp\n\t"
+        "popq %r15\n\t"
+        "popq %r14\n\t"
+        "popq %r13\n\t"
+        "popq %r12\n\t"
+        "popq %rbx\n\t"
+        "popq %rbp\n\t"
+        "ret\n\t");
+}
+#endif
+
+// Next unfinished work-item after the current one, or nullptr if none
+inline Fiber* next_fiber(Worker& w) {
+    const int n = int(w.fibers.size());
+    for (int i = 1; i <= n; ++i) {
+        Fiber* f = &w.fibers[(w.current->linear + i) % n];
+        if (!f->done) return f;
+    }
+    return nullptr;
+}
+
+// Switches straight to the next work-item instead of going through the
+// scheduler, so a barrier costs one context switch per work-item
+inline void yield() {
+    Worker& w = worker();
+    Fiber* self = w.current;
+    Fiber* next = next_fiber(w);
+    if (next == self) return;
+    w.current = next;
+#if defined(__x86_64__)
+    ctx_switch(&self->sp, next->sp);
+#else
+    swapcontext(&self->ctx, &next->ctx);
+#endif
+}
+
+inline void release_if_complete(Barrier& b) {
+    if (b.arrived > 0 && b.arrived == b.live) {
+        b.arrived = 0;
+        ++b.gen;
+    }
+}
+
+inline void barrier_wait(Barrier& b) {
+    const unsigned gen = b.gen;
+    if (++b.arrived == b.live) {
+        b.arrived = 0;
+        ++b.gen;
+        return;
+    }
+    while (b.gen == gen) yield();
+}
+
+inline Barrier& warp_barrier() {
+    Worker& w = worker();
+    return w.block.warp_bar[w.current->linear / warpSize];
+}
+
+[[noreturn]] inline void fiber_main() {
+    Worker& w = worker();
+    (*w.block.body)();
+    Fiber* f = w.current;
+    f->done = true;
+    --w.block.block_bar.live;
+    release_if_complete(w.block.block_bar);
+    Barrier& wb = w.block.warp_bar[f->linear / warpSize];
+    --wb.live;
+    release_if_complete(wb);
+    Fiber* next = next_fiber(w);
+#if defined(__x86_64__)
+    if (next) {
+        w.current = next;
+        ctx_switch(&f->sp, next->sp);
+    } else {
+        ctx_switch(&f->sp, w.sched_sp);
+    }
+#else
+    if (next) {
+        w.current = next;
+        setcontext(&next->ctx);
+    } else {
+        setcontext(&w.sched_ctx);
+    }
+#endif
+    __builtin_unreachable();
+}
+
+inline void reserve_stacks(Worker& w, size_t count) {
+    if (w.stacks_count >= count) return;
+    if (w.stacks) munmap(w.stacks, w.stacks_count * kFiberStack);
+    // MAP_NORESERVE: only the pages a fiber actually touches are committed.
+    void* p = mmap(nullptr, count * kFiberStack, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "hip_cpu: cannot map %zu fiber stacks\n", count);
+        std::abort();
+    }
+    w.stacks = static_cast<char*>(p);
+    w.stacks_count = count;
+}
+
+inline void run_block(const dim3& idx, const dim3& dim, const dim3& grid,
+                      std::function<void()>& body, size_t shmem) {
+    Worker& w = worker();
+    const int n = int(dim.x * dim.y * dim.z);
+    const int nwarps = (n + warpSize - 1) / warpSize;
+
+    Block& blk = w.block;
+    blk.idx = idx;
+    blk.dim = dim;
+    blk.grid = grid;
+    blk.body = &body;
+    blk.block_bar = Barrier{0, n, 0};
+    blk.warp_bar.assign(nwarps, Barrier{});
+    for (int wi = 0; wi < nwarps; ++wi)
+        blk.warp_bar[wi].live = std::min(warpSize, n - wi * warpSize);
+    blk.lanes.resize(n);
+    if (w.shared.size() < shmem) w.shared.resize(shmem);
+
+    reserve_stacks(w, n);
+    w.fibers.resize(n);
+    for (int t = 0; t < n; ++t) {
+        Fiber& f = w.fibers[t];
+        f.linear = t;
+        f.tid = dim3(t % dim.x, (t / dim.x) % dim.y, t / (dim.x * dim.y));
+        f.done = false;
+        f.stack = w.stacks + size_t(t) * kFiberStack;
+#if defined(__x86_64__)
+        // Initial frame: six callee-saved registers, then fiber_main as the
+        // return address, leaving rsp % 16 == 8 at its entry as the ABI expects.
+        uintptr_t top = (reinterpret_cast<uintptr_t>(f.stack) + kFiberStack) & ~uintptr_t(15);
+        void** sp = reinterpret_cast<void**>(top);
+        *--sp = nullptr;
+        *--sp = reinterpret_cast<void*>(&fiber_main);
+        for (int r = 0; r < 6; ++r) *--sp = nullptr;
+        f.sp = sp;
+#else
+        getcontext(&f.ctx);
+        f.ctx.uc_stack.ss_sp = f.stack;
+        f.ctx.uc_stack.ss_size = kFiberStack;
+        f.ctx.uc_link = nullptr;
+        makecontext(&f.ctx, reinterpret_cast<void (*)()>(&fiber_main), 0);
+#endif
+    }
+
+    // Work-items pass control round-robin among themselves (see yield); the
+    // scheduler context is resumed once the last one has returned. A
+    // work-item runs until it finishes or waits, so barrier-free kernels
+    // take one pass.
+    w.current = &w.fibers[0];
+#if defined(__x86_64__)
+    ctx_switch(&w.sched_sp, w.fibers[0].sp);
+#else
+    swapcontext(&w.sched_ctx, &w.fibers[0].ctx);
+#endif
+    w.current = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Persistent worker pool; the launching thread participates as well.
+// ---------------------------------------------------------------------------
+class Pool {
+public:
+    static Pool& instance() {
+        static Pool pool;
+        return pool;
+    }
+
+    void run(const dim3& grid, const dim3& block, size_t shmem, std::function<void()>& body) {
+        const long total = long(grid.x) * grid.y * grid.z;
+        if (total <= 0) return;
+        std::unique_lock<std::mutex> launch_lock(launch_mtx_);
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            grid_ = grid;
+            block_ = block;
+            shmem_ = shmem;
+            body_ = &body;
+            total_ = total;
+            next_.store(0);
+            active_ = int(threads_.size());
+            ++epoch_;
+        }
+        cv_.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lk(mtx_);
+        done_cv_.wait(lk, [&] { return active_ == 0; });
+    }
+
+    size_t size() const { return threads_.size() + 1; }
+
+private:
+    Pool() {
+        // HIP_CPU_THREADS, else HPC_THREADS like the host loops, else all cores
+        unsigned n = std::thread::hardware_concurrency();
+        if (const char* env = std::getenv("HPC_THREADS")) n = unsigned(std::atoi(env));
+        if (const char* env = std::getenv("HIP_CPU_THREADS")) n = unsigned(std::atoi(env));
+        if (n == 0) n = 1;
+        for (unsigned i = 1; i < n; ++i) threads_.emplace_back([this] { loop(); });
+    }
+
+    ~Pool() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    void drain() {
+        for (long b = next_.fetch_add(1); b < total_; b = next_.fetch_add(1)) {
+            dim3 idx(uint32_t(b % grid_.x), uint32_t((b / grid_.x) % grid_.y),
+                     uint32_t(b / (long(grid_.x) * grid_.y)));
+            run_block(idx, block_, grid_, *body_, shmem_);
+        }
+    }
+
+    void loop() {
+        unsigned seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(mtx_);
+                cv_.wait(lk, [&] { return stop_ || epoch_ != seen; });
+                if (stop_) return;
+                seen = epoch_;
+            }
+            drain();
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (--active_ == 0) done_cv_.notify_all();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex launch_mtx_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    bool stop_ = false;
+    unsigned epoch_ = 0;
+    int active_ = 0;
+    dim3 grid_, block_;
+    size_t shmem_ = 0;
+    std::function<void()>* body_ = nullptr;
+    long total_ = 0;
+    std::atomic<long> next_{0};
+};
+
+template <typename T>
+inline T shfl_from(T var, int src_linear) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "hip_cpu: __shfl on wide type");
+    Worker& w = worker();
+    const int self = w.current->linear;
+    std::memcpy(&w.block.lanes[self], &var, sizeof(T));
+    barrier_wait(warp_barrier());
+    T out = var;
+    if (src_linear != self) std::memcpy(&out, &w.block.lanes[src_linear], sizeof(T));
+    barrier_wait(warp_barrier());
+    return out;
+}
+
+}  // namespace detail
+
+template <typename... Params, typename... Args>
+inline void launch(void (*kernel)(Params...), dim3 grid, dim3 block, size_t shmem,
+                   hipStream_t, Args&&... args) {
+    const int n = int(block.x * block.y * block.z);
+    if (n <= 0 || n > detail::kMaxBlockThreads) {
+        fprintf(stderr, "hip_cpu: invalid block size %d\n", n);
+        std::abort();
+    }
+    std::tuple<std::decay_t<Params>...> params(static_cast<std::decay_t<Params>>(args)...);
+    std::function<void()> body = [&] { std::apply(kernel, params); };
+    detail::Pool::instance().run(grid, block, shmem, body);
+}
+
+}  // namespace hip_cpu
+
+#define threadIdx (::hip_cpu::detail::thread_idx())
+#define blockIdx (::hip_cpu::detail::block_idx())
+#define blockDim (::hip_cpu::detail::block_dim())
+#define gridDim (::hip_cpu::detail::grid_dim())
+
+#define hipLaunchKernelGGL(kernel, grid, block, shmem, stream, ...) \
+    ::hip_cpu::launch(kernel, dim3(grid), dim3(block), size_t(shmem), stream, ##__VA_ARGS__)
+#define HIP_KERNEL_NAME(...) __VA_ARGS__
+
+// ---------------------------------------------------------------------------
+// Device intrinsics
+// ---------------------------------------------------------------------------
+inline void __syncthreads() {
+    ::hip_cpu::detail::barrier_wait(::hip_cpu::detail::worker().block.block_bar);
+}
+
+inline void __threadfence() { std::atomic_thread_fence(std::memory_order_seq_cst); }
+inline void __threadfence_block() {}
+
+template <typename T>
+inline T __shfl_up(T var, unsigned delta, int width = warpSize) {
+    const int self = ::hip_cpu::detail::worker().current->linear;
+    const int lane = self % width;
+    return ::hip_cpu::detail::shfl_from(var, lane >= int(delta) ? self - int(delta) : self);
+}
+
+template <typename T>
+inline T __shfl_down(T var, unsigned delta, int width = warpSize) {
+    auto& w = ::hip_cpu::detail::worker();
+    const int self = w.current->linear;
+    const int lane = self % width;
+    const int n = int(w.block.lanes.size());
+    const int src = (lane + int(delta) < width && self + int(delta) < n) ? self + int(delta) : self;
+    return ::hip_cpu::detail::shfl_from(var, src);
+}
+
+template <typename T>
+inline T __shfl_xor(T var, int mask, int width = warpSize) {
+    auto& w = ::hip_cpu::detail::worker();
+    const int self = w.current->linear;
+    const int base = self - self % width;
+    const int src = base + ((self % width) ^ mask);
+    return ::hip_cpu::detail::shfl_from(var, src < int(w.block.lanes.size()) ? src : self);
+}
+
+template <typename T>
+inline T __shfl(T var, int src_lane, int width = warpSize) {
+    const int self = ::hip_cpu::detail::worker().current->linear;
+    const int base = self - self % width;
+    return ::hip_cpu::detail::shfl_from(var, base + (src_lane % width));
+}
+
+template <typename T>
+inline T atomicAdd(T* addr, T val) {
+    return __atomic_fetch_add(addr, val, __ATOMIC_RELAXED);
+}
+
+template <typename T>
+inline T atomicMin(T* addr, T val) {
+    T old = __atomic_load_n(addr, __ATOMIC_RELAXED);
+    while (val < old &&
+           !__atomic_compare_exchange_n(addr, &old, val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    return old;
+}
+
+template <typename T>
+inline T atomicMax(T* addr, T val) {
+    T old = __atomic_load_n(addr, __ATOMIC_RELAXED);
+    while (val > old &&
+           !__atomic_compare_exchange_n(addr, &old, val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    return old;
+}
+
+// ---------------------------------------------------------------------------
+// Host API
+// ---------------------------------------------------------------------------
+inline const char* hipGetErrorString(hipError_t err) {
+    switch (err) {
+        case hipSuccess: return "hipSuccess";
+        case hipErrorInvalidValue: return "hipErrorInvalidValue";
+        case hipErrorOutOfMemory: return "hipErrorOutOfMemory";
+    }
+    return "hipErrorUnknown";
+}
+
+inline hipError_t hipGetLastError() { return hipSuccess; }
+inline hipError_t hipSetDevice(int) { return hipSuccess; }
+inline hipError_t hipGetDeviceCount(int* count) { *count = 1; return hipSuccess; }
+inline hipError_t hipDeviceSynchronize() { return hipSuccess; }
+
+template <typename T>
+inline hipError_t hipMalloc(T** ptr, size_t bytes) {
+    void* p = nullptr;
+    if (posix_memalign(&p, 256, bytes ? bytes : 1) != 0) return hipErrorOutOfMemory;
+    *ptr = static_cast<T*>(p);
+    return hipSuccess;
+}
+
+template <typename T>
+inline hipError_t hipHostMalloc(T** ptr, size_t bytes, unsigned = 0) {
+    return hipMalloc(ptr, bytes);
+}
+
+inline hipError_t hipFree(void* ptr) {
+    std::free(ptr);
+    return hipSuccess;
+}
+
+inline hipError_t hipHostFree(void* ptr) { return hipFree(ptr); }
+
+inline hipError_t hipMemcpy(void* dst, const void* src, size_t bytes, hipMemcpyKind) {
+    if (bytes) std::memmove(dst, src, bytes);
+    return hipSuccess;
+}
+
+inline hipError_t hipMemcpyAsync(void* dst, const void* src, size_t bytes, hipMemcpyKind kind,
+                                 hipStream_t = nullptr) {
+    return hipMemcpy(dst, src, bytes, kind);
+}
+
+inline hipError_t hipMemset(void* dst, int value, size_t bytes) {
+    std::memset(dst, value, bytes);
+    return hipSuccess;
+}
+
+inline hipError_t hipMemsetAsync(void* dst, int value, size_t bytes, hipStream_t = nullptr) {
+    return hipMemset(dst, value, bytes);
+}
+
+inline hipError_t hipStreamCreate(hipStream_t* stream) {
+    *stream = nullptr;
+    return hipSuccess;
+}
+
+inline hipError_t hipStreamCreateWithFlags(hipStream_t* stream, unsigned) {
+    return hipStreamCreate(stream);
+}
+
+inline hipError_t hipStreamDestroy(hipStream_t) { return hipSuccess; }
+inline hipError_t hipStreamSynchronize(hipStream_t) { return hipSuccess; }
+inline hipError_t hipStreamWaitEvent(hipStream_t, hipEvent_t, unsigned) { return hipSuccess; }
+
+inline hipError_t hipEventCreate(hipEvent_t* event) {
+    *event = new ihipEvent_t{std::chrono::steady_clock::now()};
+    return hipSuccess;
+}
+
+inline hipError_t hipEventCreateWithFlags(hipEvent_t* event, unsigned) {
+    return hipEventCreate(event);
+}
+
+inline hipError_t hipEventRecord(hipEvent_t event, hipStream_t = nullptr) {
+    event->stamp = std::chrono::steady_clock::now();
+    return hipSuccess;
+}
+
+inline hipError_t hipEventSynchronize(hipEvent_t) { return hipSuccess; }
+
+inline hipError_t hipEventElapsedTime(float* ms, hipEvent_t start, hipEvent_t stop) {
+    *ms = std::chrono::duration<float, std::milli>(stop->stamp - start->stamp).count();
+    return hipSuccess;
+}
+
+inline hipError_t hipEventDestroy(hipEvent_t event) {
+    delete event;
+    return hipSuccess;
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef COMMON_NUMA_ALLOC_H
+#define COMMON_NUMA_ALLOC_H
+
+// NUMA-aware host buffers for the large matrices and arrays.
+//
+// Linux places an anonymous page on the node of the thread that first writes
+// it. A buffer filled by one thread therefore ends up on one node, and every
+// later multithreaded pass pulls most of its data over the interconnect.
+//   - numa_alloc::vector<T> is a std::vector whose storage comes from mmap
+//     and whose resize() leaves trivial elements uninitialised, so nothing
+//     is touched before the caller's own parallel fill
+//   - first_touch() fills [0, n) with parallel_for_ranges, i.e. with the
+//     same per-worker ranges the solvers use afterwards; with
+//     HPC_PIN_THREADS=1 each worker also stays on its CPU
+//   - HPC_HUGEPAGES=off|2m|1g (default off, opt-in): 2m asks for
+//     transparent huge pages (MADV_HUGEPAGE); 1g maps buffers of 1 GB or
+//     more from the hugetlbfs pool (MAP_HUGE_1GB) and falls back to 2m if
+//     it is empty
+//   - HPC_NUMA_REPORT=1 prints the per-node placement of each buffer passed
+//     to report() on stderr, sampled with move_pages(2)
+// Buffers under NUMA_ALLOC_MIN_BYTES use malloc.
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "parallel.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#define NUMA_ALLOC_MIN_BYTES (size_t(2) << 20)
+#define NUMA_ALLOC_2M (size_t(1) << 21)
+#define NUMA_ALLOC_1G (size_t(1) << 30)
+
+namespace numa_alloc {
+
+enum HugePages { HUGE_OFF, HUGE_2M, HUGE_1G };
+
+struct Config {
+    HugePages huge = HUGE_OFF;
+    bool report = false;
+};
+
+inline const Config& config() {
+    static const Config cfg = [] {
+        Config c;
+        const char* huge = std::getenv("HPC_HUGEPAGES");
+        if (huge && std::strcmp(huge, "2m") == 0) c.huge = HUGE_2M;
+        if (huge && std::strcmp(huge, "1g") == 0) c.huge = HUGE_1G;
+        const char* report = std::getenv("HPC_NUMA_REPORT");
+        c.report = report && std::atoi(report) > 0;
+        return c;
+    }();
+    return cfg;
+}
+
+inline bool use_1g(size_t bytes) {
+    return config().huge == HUGE_1G && bytes >= NUMA_ALLOC_1G;
+}
+
+// Length actually mapped for a request of `bytes`; also used by release()
+inline size_t mapped_bytes(size_t bytes) {
+    const size_t align = use_1g(bytes) ? NUMA_ALLOC_1G : NUMA_ALLOC_2M;
+    return (bytes + align - 1) / align * align;
+}
+
+inline void* allocate(size_t bytes) {
+    if (bytes < NUMA_ALLOC_MIN_BYTES) {
+        void* p = std::malloc(bytes ? bytes : 1);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+    const size_t len = mapped_bytes(bytes);
+    void* p = MAP_FAILED;
+    if (use_1g(bytes)) {
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_HUGETLB | MAP_HUGE_1GB, -1, 0);
+        if (p == MAP_FAILED && config().report) {
+            std::fprintf(stderr, "[numa] no 1 GB huge pages (%s), using 2 MB pages\n", std::strerror(errno));
+        }
+    }
+    if (p == MAP_FAILED) {
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        if (config().huge != HUGE_OFF) madvise(p, len, MADV_HUGEPAGE);
+    }
+    return p;
+}
+
+inline void release(void* p, size_t bytes) {
+    if (!p) return;
+    if (bytes < NUMA_ALLOC_MIN_BYTES) std::free(p);
+    else munmap(p, mapped_bytes(bytes));
+}
+
+// Allocator for numa_alloc::vector. construct() without arguments
+// default-initialises, so resize(n) does not write trivial elements.
+template <typename T>
+struct Allocator {
+    typedef T value_type;
+
+    Allocator() = default;
+    template <typename U>
+    Allocator(const Allocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(numa_alloc::allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { release(p, n * sizeof(T)); }
+
+    template <typename U>
+    void construct(U* p) {
+        ::new (static_cast<void*>(p)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const Allocator<T>&, const Allocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const Allocator<T>&, const Allocator<U>&) { return false; }
+
+template <typename T>
+using vector = std::vector<T, Allocator<T>>;
+
+// Parallel fill, one contiguous range per worker
+template <typename T>
+void first_touch(T* data, size_t n, const T& value) {
+    parallel_for_ranges(n, [&](size_t b, size_t e, int) {
+        std::fill(data + b, data + e, value);
+    });
+}
+
+// Prints "[numa] name: size, hugepages=mode, node0 x% node1 y% ..." when
+// HPC_NUMA_REPORT is set; mode is the one requested for this buffer. At
+// most 65536 pages are sampled; pages never touched count as "untouched".
+inline void report(const char* name, const void* data, size_t bytes) {
+    if (!config().report || !data || bytes == 0) return;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t first = (uintptr_t)data / page * page;
+    const size_t pages = ((uintptr_t)data + bytes - first + page - 1) / page;
+    const size_t samples = std::min<size_t>(pages, 65536);
+
+    std::vector<void*> addr(samples);
+    std::vector<int> status(samples, -1);
+    for (size_t i = 0; i < samples; ++i) addr[i] = (void*)(first + pages * i / samples * page);
+    if (syscall(SYS_move_pages, 0, (unsigned long)samples, addr.data(), nullptr, status.data(), 0) != 0) {
+        std::fprintf(stderr, "[numa] %s: move_pages failed (%s)\n", name, std::strerror(errno));
+        return;
+    }
+
+    std::vector<size_t> per_node;
+    size_t untouched = 0;
+    for (int s : status) {
+        if (s < 0) {
+            ++untouched;
+            continue;
+        }
+        if ((size_t)s >= per_node.size()) per_node.resize(s + 1, 0);
+        ++per_node[s];
+    }
+    static const char* huge_names[] = {"off", "2m", "1g"};
+    const char* huge = bytes < NUMA_ALLOC_MIN_BYTES ? "malloc"
+                     : huge_names[use_1g(bytes) ? HUGE_1G : config().huge == HUGE_OFF ? HUGE_OFF : HUGE_2M];
+    std::fprintf(stderr, "[numa] %s: %.2f MB, hugepages=%s,", name, bytes / 1048576.0, huge);
+    for (size_t n = 0; n < per_node.size(); ++n) {
+        if (per_node[n]) std::fprintf(stderr, " node%zu %.1f%%", n, 100.0 * per_node[n] / samples);
+    }
+    if (untouched) std::fprintf(stderr, " untouched %.1f%%", 100.0 * untouched / samples);
+    std::fprintf(stderr, " (threads=%d%s)\n", host_thread_count(), host_pin_threads() ? ", pinned" : "");
+}
+
+}  // namespace numa_alloc
+
+#endif
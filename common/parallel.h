@@ -0,0 +1,218 @@
+#ifndef COMMON_PARALLEL_H
+#define COMMON_PARALLEL_H
+
+// Host-side parallel loops shared by the three solvers.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+// Worker count for host loops; HPC_THREADS overrides the hardware count
+inline int host_thread_count() {
+    static const int count = [] {
+        const char* env = std::getenv("HPC_THREADS");
+        int n = env ? std::atoi(env) : (int)std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }();
+    return count;
+}
+
+// HPC_PIN_THREADS=1 pins pool worker w to the w-th allowed CPU, CPUs taken
+// node by node, so that consecutive ranges stay on one NUMA node
+inline bool host_pin_threads() {
+    static const bool pin = [] {
+        const char* env = std::getenv("HPC_PIN_THREADS");
+        return env && std::atoi(env) > 0;
+    }();
+    return pin;
+}
+
+// Parses a sysfs cpulist such as "0-15,32-47"
+inline std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> cpus;
+    size_t p = 0;
+    while (p < text.size()) {
+        size_t comma = text.find(',', p);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = text.substr(p, comma - p);
+        size_t dash = item.find('-');
+        int lo = std::atoi(item.c_str());
+        int hi = dash == std::string::npos ? lo : std::atoi(item.c_str() + dash + 1);
+        if (!item.empty() && item[0] >= '0' && item[0] <= '9') {
+            for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+        }
+        p = comma + 1;
+    }
+    return cpus;
+}
+
+// CPUs this process may run on, grouped by NUMA node (node 0 first); falls
+// back to the affinity mask order when sysfs has no node information
+inline std::vector<int> host_cpu_order() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return {};
+    std::vector<int> order;
+    std::vector<char> seen(CPU_SETSIZE, 0);
+    for (int node = 0; node < 1024; ++node) {
+        std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+        FILE* f = std::fopen(path.c_str(), "r");
+        if (!f) {
+            if (node > 0) break;
+            continue;
+        }
+        char buf[4096];
+        size_t len = std::fread(buf, 1, sizeof(buf) - 1, f);
+        std::fclose(f);
+        buf[len] = 0;
+        for (int c : parse_cpu_list(buf)) {
+            if (c >= 0 && c < CPU_SETSIZE && CPU_ISSET(c, &allowed) && !seen[c]) {
+                seen[c] = 1;
+                order.push_back(c);
+            }
+        }
+    }
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+        if (CPU_ISSET(c, &allowed) && !seen[c]) order.push_back(c);
+    }
+    return order;
+}
+
+// Persistent workers behind parallel_for_ranges, so that a resident process
+// does not create threads per call. One loop runs at a time; a loop started
+// while another is running (including from inside a task) runs inline.
+// Task w < size() always runs on the same thread, so a range first touched
+// by worker w is later processed on the CPU (and NUMA node) that placed it.
+// With pinning the caller only waits: pinning it would leak the mask to
+// every thread it creates later (HIP runtime, CPU backend workers).
+class HostThreadPool {
+public:
+    static HostThreadPool& instance() {
+        static HostThreadPool pool(host_thread_count());
+        return pool;
+    }
+
+    int size() const { return size_; }
+
+    // Runs task(w) for w in [0, tasks); false if the pool is busy
+    bool try_run(int tasks, const std::function<void(int)>& task) {
+        bool expected = false;
+        if (!busy_.compare_exchange_strong(expected, true)) return false;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            task_ = &task;
+            tasks_ = tasks;
+            next_.store(size_);
+            pending_ = (int)threads_.size();
+            ++epoch_;
+        }
+        cv_.notify_all();
+        if (first_worker_ == 1 && tasks > 0) task(0);
+        drain();
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            done_cv_.wait(lk, [&] { return pending_ == 0; });
+        }
+        busy_.store(false);
+        return true;
+    }
+
+private:
+    explicit HostThreadPool(int n) : size_(n) {
+        std::vector<int> cpus;
+        if (host_pin_threads()) cpus = host_cpu_order();
+        first_worker_ = cpus.empty() ? 1 : 0;
+        for (int w = first_worker_; w < n; ++w) {
+            const int cpu = cpus.empty() ? -1 : cpus[w % cpus.size()];
+            threads_.emplace_back([this, w, cpu] {
+                if (cpu >= 0) {
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(cpu, &set);
+                    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+                }
+                loop(w);
+            });
+        }
+    }
+
+    ~HostThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    // Tasks beyond size() are handed out dynamically
+    void drain() {
+        for (int w = next_.fetch_add(1); w < tasks_; w = next_.fetch_add(1)) (*task_)(w);
+    }
+
+    void loop(int worker) {
+        unsigned seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(mtx_);
+                cv_.wait(lk, [&] { return stop_ || epoch_ != seen; });
+                if (stop_) return;
+                seen = epoch_;
+            }
+            if (worker < tasks_) (*task_)(worker);
+            drain();
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (--pending_ == 0) done_cv_.notify_all();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    int size_ = 1;
+    int first_worker_ = 1;  // 0 when the caller does not run tasks
+    std::atomic<bool> busy_{false};
+    std::mutex mtx_;
+    std::condition_variable cv_, done_cv_;
+    bool stop_ = false;
+    unsigned epoch_ = 0;
+    int pending_ = 0;
+    int tasks_ = 0;
+    const std::function<void(int)>* task_ = nullptr;
+    std::atomic<int> next_{0};
+};
+
+// Splits [0, n) into one contiguous range per worker and runs
+// fn(begin, end, worker) on each; the calling thread takes worker 0.
+template <typename Fn>
+void parallel_for_ranges(size_t n, Fn fn, int max_workers = 0) {
+    int workers = host_thread_count();
+    if (max_workers > 0) workers = std::min(workers, max_workers);
+    workers = (int)std::min<size_t>(workers, n);
+    if (workers <= 1) {
+        if (n > 0) fn(size_t(0), n, 0);
+        return;
+    }
+
+    const size_t step = (n + workers - 1) / workers;
+    std::function<void(int)> task = [&](int w) {
+        size_t begin = std::min(n, step * w);
+        size_t end = std::min(n, begin + step);
+        if (begin < end) fn(begin, end, w);
+    };
+    if (!HostThreadPool::instance().try_run(workers, task)) {
+        // Nested or concurrent loop: the workers are taken, run the ranges here
+        for (int w = 0; w < workers; ++w) task(w);
+    }
+}
+
+#endif
@@ -0,0 +1,297 @@
+#ifndef COMMON_SOLVER_SERVER_H
+#define COMMON_SOLVER_SERVER_H
+
+// Resident solver service over a local Unix socket.
+//
+// `<binary> --serve SOCKET` keeps one process, and with it the host thread
+// pool, the device context, streams and cached device buffers, alive across
+// jobs. A client connects and sends a single request line
+//     <problem> <input_file> [options...] [--output PATH]
+// where <problem> must match the binary (softmax, prefix_sum, apsp) and the
+// options are the ones the command line accepts after <input_file>. The
+// input may be any readable path, including a shared-memory segment under
+// /dev/shm, which avoids a copy through the socket. The reply is the result
+// text, or "OK" when --output is given; failures reply "ERR <message>".
+// The server closes the connection after the reply.
+//
+// Trust model: a client runs jobs with the server's credentials. --output
+// creates or truncates any file the server user may write, and the input
+// path may name any file it may read. The socket is therefore created with
+// mode 0600, so only the user that started the server (and root) can
+// connect; do not relax that, or proxy the socket to other users.
+//
+// Connections stay non-blocking throughout: replies go through
+// fd_io::write_all, so a client that stops reading is dropped after
+// FD_IO_STALL_TIMEOUT_MS and the jobs queued behind it are not held up.
+//
+// An acceptor thread polls the listening socket and every connection whose
+// request line is still incomplete, so a slow or idle client only holds its
+// own connection (dropped after SERVER_RECV_TIMEOUT_MS). Complete requests
+// are queued; the solve thread takes everything queued (up to
+// SERVER_MAX_BATCH) and passes it to the batch handler in one call. It only
+// waits, for at most SERVER_BATCH_WINDOW_US, while other clients are still
+// sending requests, so a lone job is dispatched at once while jobs that
+// arrive together can share a launch. SIGINT/SIGTERM drain the queue,
+// remove the socket file and return from serve().
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "fd_io.h"
+
+#define SERVER_MAX_BATCH 64
+#define SERVER_BATCH_WINDOW_US 2000
+#define SERVER_MAX_REQUEST 4096
+#define SERVER_RECV_TIMEOUT_MS 2000
+
+namespace solver_server {
+
+struct Job {
+    int fd = -1;                    // client connection
+    std::vector<std::string> args;  // input file followed by the job options
+    std::string output_path;        // empty: the result is the reply
+    int out_fd = -1;                // where the handler writes the result text
+    std::string error;              // set by the handler on failure
+};
+
+inline std::atomic<bool>& stop_flag() {
+    static std::atomic<bool> stop(false);
+    return stop;
+}
+
+inline void on_signal(int) { stop_flag().store(true); }
+
+// A connection whose request line has not fully arrived yet
+struct PendingRequest {
+    int fd = -1;
+    std::string data;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+// Reads what is available on a non-blocking connection. Returns 1 once the
+// request line is complete (in line), 0 if more data is needed, -1 on EOF
+// before a newline, a read error or an oversized request.
+inline int read_available(PendingRequest& req, std::string& line) {
+    char buf[SERVER_MAX_REQUEST];
+    for (;;) {
+        ssize_t n = ::read(req.fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        if (n == 0) return -1;
+        req.data.append(buf, (size_t)n);
+        size_t nl = req.data.find('\n');
+        if (nl != std::string::npos) {
+            line.assign(req.data, 0, nl);
+            return 1;
+        }
+        if (req.data.size() >= SERVER_MAX_REQUEST) return -1;
+    }
+}
+
+// Splits "<problem> <input_file> [options...] [--output PATH]" into job
+inline bool parse_request(const std::string& line, const char* problem, Job& job,
+                          std::string& err) {
+    std::istringstream in(line);
+    std::string word;
+    if (!(in >> word) || word != problem) {
+        err = "this server only runs " + std::string(problem) + " jobs";
+        return false;
+    }
+    while (in >> word) {
+        if (word == "--output") {
+            if (!(in >> job.output_path)) {
+                err = "--output needs a path";
+                return false;
+            }
+        } else {
+            job.args.push_back(word);
+        }
+    }
+    if (job.args.empty()) {
+        err = "missing input file";
+        return false;
+    }
+    return true;
+}
+
+// Sends the status for a finished job and closes its descriptors
+inline void finish(Job& job) {
+    if (!job.output_path.empty() && job.out_fd >= 0) ::close(job.out_fd);
+    if (!job.error.empty()) {
+        fd_io::write_all(job.fd, "ERR " + job.error + "\n");
+    } else if (!job.output_path.empty()) {
+        fd_io::write_all(job.fd, "OK\n");
+    }
+    ::close(job.fd);
+}
+
+// Serves `problem` jobs on socket_path until SIGINT/SIGTERM.
+// handler(std::vector<Job>& batch) writes each job's result to job.out_fd
+// or sets job.error; it runs on the calling thread, one batch at a time.
+template <typename BatchHandler>
+int serve(const std::string& socket_path, const char* problem, BatchHandler handler) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::fprintf(stderr, "socket path too long: %s\n", socket_path.c_str());
+        return 1;
+    }
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listen_fd < 0) {
+        std::perror("socket");
+        return 1;
+    }
+    ::unlink(socket_path.c_str());  // stale socket from an earlier run
+    // Owner-only socket, see the trust model above
+    const mode_t old_mask = ::umask(0177);
+    const int bound = ::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::umask(old_mask);
+    if (bound != 0 || ::listen(listen_fd, SOMAXCONN) != 0) {
+        std::perror("bind");
+        ::close(listen_fd);
+        return 1;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);  // clients may hang up before the reply
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::fprintf(stderr, "[serve] %s listening on %s\n", problem, socket_path.c_str());
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Job> queue;
+    size_t receiving = 0;  // connections with an incomplete request line
+    bool acceptor_done = false;
+
+    std::thread acceptor([&] {
+        std::vector<PendingRequest> pending;
+        std::vector<pollfd> pfds;
+        std::vector<Job> ready;
+        while (!stop_flag().load()) {
+            auto now = std::chrono::steady_clock::now();
+            int timeout_ms = 200;
+            pfds.assign(1, pollfd{listen_fd, POLLIN, 0});
+            for (const PendingRequest& req : pending) {
+                pfds.push_back(pollfd{req.fd, POLLIN, 0});
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(req.deadline - now).count();
+                timeout_ms = (int)std::max<long long>(0, std::min<long long>(timeout_ms, left + 1));
+            }
+            if (::poll(pfds.data(), pfds.size(), timeout_ms) < 0 && errno != EINTR) break;
+
+            // Requests that complete (or fail) in this round
+            now = std::chrono::steady_clock::now();
+            size_t keep = 0;
+            for (size_t i = 0; i < pending.size(); ++i) {
+                PendingRequest& req = pending[i];
+                std::string line;
+                int state = pfds[i + 1].revents ? read_available(req, line) : 0;
+                if (state == 0 && now >= req.deadline) state = -1;
+                if (state == 0) {
+                    pending[keep++] = std::move(req);
+                    continue;
+                }
+                // The connection stays non-blocking: fd_io::write_all drops
+                // a client that stops reading instead of stalling the solver
+                Job job;
+                job.fd = req.fd;
+                if (state < 0) {
+                    job.error = "malformed request";
+                } else {
+                    parse_request(line, problem, job, job.error);
+                }
+                if (job.error.empty()) {
+                    job.out_fd = job.fd;
+                    if (!job.output_path.empty()) {
+                        job.out_fd = ::open(job.output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                        if (job.out_fd < 0) job.error = "cannot open " + job.output_path;
+                    }
+                }
+                if (job.error.empty()) {
+                    ready.push_back(std::move(job));
+                } else {
+                    finish(job);
+                }
+            }
+            pending.resize(keep);
+
+            if (pfds[0].revents & POLLIN) {
+                for (;;) {
+                    int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                    if (fd < 0) break;  // EAGAIN: backlog drained
+                    PendingRequest req;
+                    req.fd = fd;
+                    req.deadline = now + std::chrono::milliseconds(SERVER_RECV_TIMEOUT_MS);
+                    pending.push_back(std::move(req));
+                }
+            }
+
+            std::lock_guard<std::mutex> lk(mtx);
+            for (Job& job : ready) queue.push_back(std::move(job));
+            ready.clear();
+            receiving = pending.size();
+            cv.notify_one();
+        }
+        for (PendingRequest& req : pending) ::close(req.fd);
+        std::lock_guard<std::mutex> lk(mtx);
+        receiving = 0;
+        acceptor_done = true;
+        cv.notify_one();
+    });
+
+    std::vector<Job> batch;
+    for (;;) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [&] { return !queue.empty() || acceptor_done; });
+            if (queue.empty()) break;
+            // Wait for clients that are still sending a request, but only for
+            // a short window; with nobody else connected, dispatch right away
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(SERVER_BATCH_WINDOW_US);
+            cv.wait_until(lk, deadline, [&] {
+                return queue.size() >= SERVER_MAX_BATCH || receiving == 0 || acceptor_done;
+            });
+            while (!queue.empty() && batch.size() < SERVER_MAX_BATCH) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        handler(batch);
+        for (Job& job : batch) finish(job);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::fprintf(stderr, "[serve] %zu job(s) in %.3f ms\n", batch.size(), ms);
+    }
+
+    acceptor.join();
+    ::close(listen_fd);
+    ::unlink(socket_path.c_str());
+    std::fprintf(stderr, "[serve] %s stopped\n", problem);
+    return 0;
+}
+
+}  // namespace solver_server
+
+#endif
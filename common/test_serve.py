@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+# 常驻服务模式回归测试：一个客户端提交输出很大的作业后既不读取回复也不断开，
+# 另一个客户端随后提交的小作业仍须在限定时间内拿到与命令行运行一致的结果，
+# 服务进程也必须能正常退出。
+#
+# 用法: python3 test_serve.py <binary> <problem>      problem 为 apsp / prefix_sum / softmax
+import os
+import random
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+# 第二个客户端等待回复的上限（秒）；服务端丢弃不读回复的连接只需 FD_IO_STALL_TIMEOUT_MS
+REPLY_TIMEOUT = 10.0
+
+
+def write_input(problem, path, size, rng):
+    with open(path, "w") as f:
+        if problem == "apsp":
+            edges = {}
+            for v in range(size):
+                edges[(v, (v + 1) % size)] = rng.randint(0, 1000)
+            f.write("%d %d\n" % (size, len(edges)))
+            for (s, t), w in edges.items():
+                f.write("%d %d %d\n" % (s, t, w))
+        elif problem == "prefix_sum":
+            f.write("%d\n%s\n" % (size, " ".join(str(rng.randint(-1000, 1000)) for _ in range(size))))
+        else:
+            f.write("%d\n%s\n" % (size, " ".join("%.4f" % rng.uniform(-10, 10) for _ in range(size))))
+
+
+def connect(path):
+    for _ in range(100):
+        try:
+            s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            s.connect(path)
+            return s
+        except OSError:
+            s.close()
+            time.sleep(0.05)
+    raise RuntimeError("server did not start")
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("usage: test_serve.py <binary> <problem>")
+        return 2
+    binary, problem = sys.argv[1], sys.argv[2]
+    # 大作业的输出（数 MB）远超套接字缓冲区
+    big_size, small_size = {"apsp": (800, 40), "prefix_sum": (2000000, 1000),
+                            "softmax": (1000000, 1000)}[problem]
+    rng = random.Random(7)
+    failed = []
+    with tempfile.TemporaryDirectory() as tmp:
+        big, small, sock = (os.path.join(tmp, n) for n in ("big.in", "small.in", "s.sock"))
+        write_input(problem, big, big_size, rng)
+        write_input(problem, small, small_size, rng)
+        expect = subprocess.run([binary, small], stdout=subprocess.PIPE,
+                                stderr=subprocess.DEVNULL, check=True).stdout
+
+        server = subprocess.Popen([binary, "--serve", sock], stderr=subprocess.DEVNULL)
+        try:
+            stalled = connect(sock)
+            stalled.sendall(("%s %s\n" % (problem, big)).encode())
+            time.sleep(0.5)  # 让大作业先进入队列
+
+            client = connect(sock)
+            client.settimeout(REPLY_TIMEOUT)
+            client.sendall(("%s %s\n" % (problem, small)).encode())
+            reply = b""
+            try:
+                while True:
+                    data = client.recv(1 << 16)
+                    if not data:
+                        break
+                    reply += data
+            except socket.timeout:
+                failed.append("second client got no reply within %.0f s" % REPLY_TIMEOUT)
+            if not failed and reply != expect:
+                failed.append("second client reply differs from the command-line result")
+            client.close()
+            stalled.close()
+
+            server.send_signal(signal.SIGTERM)
+            try:
+                server.wait(timeout=REPLY_TIMEOUT)
+            except subprocess.TimeoutExpired:
+                failed.append("server did not stop on SIGTERM")
+        finally:
+            if server.poll() is None:
+                server.kill()
+                server.wait()
+    for msg in failed:
+        print("FAIL %s: %s" % (problem, msg))
+    print("test_serve: %s" % ("FAIL" if failed else "PASS"))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,31 +1,122 @@
 #include "main.h"
+#include <charconv>
+#include "../common/numa_alloc.h"
+#include "../common/solver_server.h"
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "usage: " << argv[0] << " <input_file>" << std::endl;
-        return 1;
-    }
-    
+// Jobs up to this size that reach the server together are scanned as one
+// concatenated array; each job's sums are recovered by subtracting the
+// running total at its first element
+#define PREFIX_BATCH_MAX_N (1 << 20)
+
+// The buffer is first touched in parallel before the (serial) parse, so its
+// pages are spread over the NUMA nodes like the host-side range splits
+static bool read_input(const std::string& filename, numa_alloc::vector<int>& input, std::string& err) {
     std::ifstream input_file;
-    std::string filename = argv[1];
-    
     input_file.open(filename);
     if (!input_file.is_open()) {
-        std::cerr << "fileopen error " << filename << std::endl;
-        return 1;
+        err = "fileopen error " + filename;
+        return false;
     }
 
     int N;
     input_file >> N;
 
-    std::vector<int> input(N), output(N);
-    for(int i = 0; i < N; ++i) 
+    input.resize(N);
+    numa_alloc::first_touch(input.data(), input.size(), 0);
+    numa_alloc::report("input", input.data(), input.size() * sizeof(int));
+    for(int i = 0; i < N; ++i)
         input_file >> input[i];
     input_file.close();
+    return true;
+}
+
+// Writes "v_0 v_1 ... v_{N-1} \n" with v_i = values[i] - base (mod 2^32)
+static bool write_result(int fd, const int* values, int N, int base) {
+    std::string buf;
+    buf.reserve(1 << 20);
+    char tmp[16];
+    for (int i = 0; i < N; ++i) {
+        int v = (int)((unsigned)values[i] - (unsigned)base);
+        char* end = std::to_chars(tmp, tmp + sizeof(tmp), v).ptr;
+        *end++ = ' ';
+        buf.append(tmp, end);
+        if (buf.size() >= (1 << 20)) {
+            if (!fd_io::write_all(fd, buf)) return false;
+            buf.clear();
+        }
+    }
+    buf += '\n';
+    return fd_io::write_all(fd, buf);
+}
+
+static bool run_job(const std::vector<std::string>& args, int out_fd, std::string& err) {
+    if (args.size() != 1) {
+        err = "usage: <input_file>";
+        return false;
+    }
+    numa_alloc::vector<int> input;
+    if (!read_input(args[0], input, err)) return false;
+    int N = (int)input.size();
+    numa_alloc::vector<int> output(N);
+    numa_alloc::first_touch(output.data(), output.size(), 0);
 
     solve(input.data(), output.data(), N);
 
-    for(int i = 0; i < N; ++i) 
-        std::cout << output[i] << " ";
-    std::cout << std::endl;
+    if (!write_result(out_fd, output.data(), N, 0)) {
+        err = "write failed";
+        return false;
+    }
+    return true;
+}
+
+// Server batch: small jobs share one scan over their concatenation
+static void serve_batch(std::vector<solver_server::Job>& batch) {
+    std::vector<solver_server::Job*> packed;
+    std::vector<size_t> offsets(1, 0);
+    std::vector<int> input;
+    for (solver_server::Job& job : batch) {
+        numa_alloc::vector<int> values;
+        if (job.args.size() != 1) {
+            run_job(job.args, job.out_fd, job.error);
+        } else if (read_input(job.args[0], values, job.error)) {
+            if (values.size() <= PREFIX_BATCH_MAX_N) {
+                packed.push_back(&job);
+                input.insert(input.end(), values.begin(), values.end());
+                offsets.push_back(input.size());
+            } else {
+                numa_alloc::vector<int> output(values.size());
+                numa_alloc::first_touch(output.data(), output.size(), 0);
+                solve(values.data(), output.data(), (int)values.size());
+                if (!write_result(job.out_fd, output.data(), (int)output.size(), 0)) job.error = "write failed";
+            }
+        }
+    }
+    if (packed.empty()) return;
+
+    std::vector<int> output(input.size());
+    solve(input.data(), output.data(), (int)input.size());
+    for (size_t j = 0; j < packed.size(); ++j) {
+        int base = offsets[j] > 0 ? output[offsets[j] - 1] : 0;
+        if (!write_result(packed[j]->out_fd, output.data() + offsets[j],
+                          (int)(offsets[j + 1] - offsets[j]), base)) {
+            packed[j]->error = "write failed";
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--serve") {
+        return solver_server::serve(argv[2], "prefix_sum", serve_batch);
+    }
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <input_file>" << std::endl;
+        std::cerr << "       " << argv[0] << " --serve <socket>" << std::endl;
+        return 1;
+    }
+
+    std::string err;
+    if (!run_job(std::vector<std::string>(1, argv[1]), STDOUT_FILENO, err)) {
+        std::cerr << err << std::endl;
+        return 1;
+    }
 }
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+# CPU 后端回归测试：用 common/hip_cpu 编译出的 prefix_sum_cpu 与串行基线
+# prefix_sum_serial 在随机输入上比较，整数结果要求逐字节一致。
+#
+# 用法: python3 test_cpu.py ./prefix_sum_serial ./prefix_sum_cpu
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+# 覆盖单块（N <= BLOCK_SIZE）、块边界，以及块和需要多级扫描的长度
+SIZES = [1, 2, 511, 512, 513, 4096, 262144, 262145, 1000003]
+
+
+def run(binary, path):
+    return subprocess.run([binary, path], stdout=subprocess.PIPE,
+                          stderr=subprocess.DEVNULL, check=True).stdout
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("usage: test_cpu.py <serial_binary> <cpu_binary>")
+        return 2
+    serial, cpu = sys.argv[1], sys.argv[2]
+    rng = random.Random(2024)
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "a.in")
+        for n in SIZES:
+            with open(path, "w") as f:
+                f.write("%d\n" % n)
+                f.write(" ".join(str(rng.randint(-1000, 1000)) for _ in range(n)))
+                f.write("\n")
+            ref, got = run(serial, path).split(), run(cpu, path).split()
+            if ref != got:
+                failed += 1
+                i = next((i for i, (x, y) in enumerate(zip(ref, got)) if x != y), min(len(ref), len(got)))
+                print("FAIL N=%d: first difference at [%d] (%d values, expected %d)"
+                      % (n, i, len(got), len(ref)))
+    print("test_cpu: %s" % ("FAIL" if failed else "PASS"))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
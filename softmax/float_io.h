@@ -0,0 +1,206 @@
+#ifndef FLOAT_IO_H
+#define FLOAT_IO_H
+
+// Fast text I/O for softmax inputs and outputs.
+//
+// Parsing maps the input file and runs std::from_chars over whitespace-
+// aligned slices in parallel. Formatting uses std::to_chars (Ryu-based in
+// libstdc++): precision P > 0 matches printf("%.Pg") and therefore the
+// default iostream output at P = 6; P = 0 selects the shortest string that
+// round-trips to the same float. Chunks are formatted in parallel into
+// per-thread buffers and emitted in order with large write() calls.
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/fd_io.h"
+#include "../common/parallel.h"
+
+#define FLOAT_IO_DEFAULT_PRECISION 6
+#define FLOAT_IO_CHUNK (1 << 16)
+// Longest "%.9g" / shortest round-trip float plus separator
+#define FLOAT_IO_MAX_CHARS 24
+
+namespace float_io {
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Parses whitespace-separated floats in [p, end) into out
+inline void parse_floats(const char* p, const char* end, std::vector<float>& out) {
+    while (true) {
+        while (p < end && is_space(*p)) ++p;
+        if (p >= end) break;
+        float v = 0.0f;
+        auto res = std::from_chars(p, end, v);
+        if (res.ec == std::errc()) {
+            p = res.ptr;
+        } else {
+            // Forms from_chars rejects (e.g. a leading '+') and values out of
+            // float range, which from_chars leaves unset: strtof gives +-inf
+            // on overflow and 0 / a subnormal on underflow
+            const char* tok_end = p;
+            while (tok_end < end && !is_space(*tok_end)) ++tok_end;
+            std::string tok(p, tok_end);
+            v = std::strtof(tok.c_str(), nullptr);
+            p = tok_end;
+        }
+        out.push_back(v);
+    }
+}
+
+// Reads "N x_1 ... x_N". Returns false if the file cannot be opened or N is
+// missing; missing values are left as 0 like the iostream reader.
+// Vec is std::vector<float> or numa_alloc::vector<float>; with the latter the
+// parsed slices are copied in by the workers that parsed them, which is the
+// first touch of the output pages.
+template <typename Vec>
+bool read_float_file(const std::string& path, Vec& values) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = (size_t)st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    const char* begin = static_cast<const char*>(map);
+    const char* end = begin + size;
+    const char* p = begin;
+    while (p < end && is_space(*p)) ++p;
+    long long n = 0;
+    auto res = std::from_chars(p, end, n);
+    if (res.ec != std::errc() || n < 0) {
+        munmap(map, size);
+        return false;
+    }
+    p = res.ptr;
+    values.resize((size_t)n);
+
+    // Slice boundaries are moved forward to the next whitespace so that no
+    // token is split between threads
+    const int workers = host_thread_count();
+    std::vector<const char*> cuts(workers + 1, end);
+    cuts[0] = p;
+    for (int w = 1; w < workers; ++w) {
+        const char* c = p + (size_t)(end - p) * w / workers;
+        c = std::max(c, cuts[w - 1]);
+        while (c < end && !is_space(*c)) ++c;
+        cuts[w] = c;
+    }
+
+    std::vector<std::vector<float>> parts(workers);
+    parallel_for_ranges(workers, [&](size_t b, size_t e, int) {
+        for (size_t w = b; w < e; ++w) {
+            parts[w].reserve((size_t)(cuts[w + 1] - cuts[w]) / 4);
+            parse_floats(cuts[w], cuts[w + 1], parts[w]);
+        }
+    });
+
+    std::vector<size_t> offsets(workers + 1, 0);
+    for (int w = 0; w < workers; ++w) offsets[w + 1] = offsets[w] + parts[w].size();
+    parallel_for_ranges(workers, [&](size_t b, size_t e, int) {
+        for (size_t w = b; w < e; ++w) {
+            size_t begin = std::min(offsets[w], values.size());
+            size_t take = std::min(offsets[w + 1], values.size()) - begin;
+            std::memcpy(values.data() + begin, parts[w].data(), take * sizeof(float));
+            if (w + 1 == (size_t)workers && offsets[w + 1] < values.size()) {
+                std::fill(values.data() + offsets[w + 1], values.data() + values.size(), 0.0f);
+            }
+        }
+    });
+    munmap(map, size);
+    return true;
+}
+
+// 9 significant digits already round-trip every float
+#define FLOAT_IO_MAX_PRECISION 9
+
+// Formats one value followed by `sep`; returns the end of the written text
+inline char* format_float(char* p, float v, int precision, char sep) {
+    std::to_chars_result res = precision > 0
+        ? std::to_chars(p, p + FLOAT_IO_MAX_CHARS, v, std::chars_format::general, precision)
+        : std::to_chars(p, p + FLOAT_IO_MAX_CHARS, v);
+    *res.ptr = sep;
+    return res.ptr + 1;
+}
+
+// Output schedule of write_floats: FLOAT_IO_CHUNK values per chunk and
+// per_round consecutive chunks per round; chunk first + r of a round goes to
+// the worker that parallel_for_ranges(round, ...) hands index r to
+struct ChunkSchedule {
+    size_t chunk, total_chunks, per_round;
+};
+
+inline ChunkSchedule chunk_schedule(int N) {
+    ChunkSchedule s;
+    s.chunk = FLOAT_IO_CHUNK;
+    s.total_chunks = ((size_t)std::max(N, 0) + s.chunk - 1) / s.chunk;
+    s.per_round = std::min((size_t)host_thread_count(), s.total_chunks);
+    return s;
+}
+
+// First touch of an output array with write_floats' chunk-to-worker mapping,
+// so every chunk's pages sit on the node of the worker that formats it
+inline void first_touch_output(float* values, int N) {
+    const ChunkSchedule s = chunk_schedule(N);
+    for (size_t first = 0; first < s.total_chunks; first += s.per_round) {
+        const size_t round = std::min(s.per_round, s.total_chunks - first);
+        parallel_for_ranges(round, [&](size_t b, size_t e, int) {
+            const size_t lo = (first + b) * s.chunk;
+            const size_t hi = std::min((size_t)N, (first + e) * s.chunk);
+            std::fill(values + lo, values + hi, 0.0f);
+        });
+    }
+}
+
+// Writes "v_0 v_1 ... v_{N-1} \n", the same layout as the iostream loop
+inline bool write_floats(int fd, const float* values, int N, int precision) {
+    precision = std::min(std::max(precision, 0), FLOAT_IO_MAX_PRECISION);
+    const ChunkSchedule sched = chunk_schedule(N);
+    const size_t chunk = sched.chunk;
+    const size_t total_chunks = sched.total_chunks;
+    // One buffer per chunk formatted in a round, never more than there are chunks
+    const size_t nbufs = sched.per_round;
+    const size_t buf_chars = std::min(chunk, (size_t)std::max(N, 0)) * FLOAT_IO_MAX_CHARS;
+    std::vector<std::vector<char>> bufs(nbufs, std::vector<char>(buf_chars));
+    std::vector<size_t> lens(nbufs);
+
+    // Each round formats up to `workers` consecutive chunks, then writes them in order
+    for (size_t first = 0; first < total_chunks; first += nbufs) {
+        const size_t round = std::min(nbufs, total_chunks - first);
+        parallel_for_ranges(round, [&](size_t b, size_t e, int) {
+            for (size_t r = b; r < e; ++r) {
+                size_t lo = (first + r) * chunk;
+                size_t hi = std::min((size_t)N, lo + chunk);
+                char* out = bufs[r].data();
+                char* p = out;
+                for (size_t i = lo; i < hi; ++i) p = format_float(p, values[i], precision, ' ');
+                lens[r] = (size_t)(p - out);
+            }
+        });
+        for (size_t r = 0; r < round; ++r) {
+            if (!fd_io::write_all(fd, bufs[r].data(), lens[r])) return false;
+        }
+    }
+    return N > 0 ? fd_io::write_all(fd, "\n", 1) : fd_io::write_all(fd, " \n", 2);
+}
+
+}  // namespace float_io
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef HALF_CONVERT_H
+#define HALF_CONVERT_H
+
+// fp16 / bf16 <-> fp32 conversion for the half-precision softmax entry points.
+//
+// Values are carried as raw uint16_t bit patterns so that the same code
+// builds for the GPU, the serial binary and the CPU backend without
+// hip_fp16.h. The scalar conversions are exact bit manipulations with
+// round-to-nearest-even and are usable on host and device. On x86-64 the
+// bulk host converters are dispatched at run time:
+//   fp16: F16C (vcvtph2ps / vcvtps2ph), 8 values per instruction
+//   bf16: AVX2 shifts for loads; AVX-512 BF16 (vcvtneps2bf16) for stores,
+//         AVX2 integer rounding when that is not available
+// Every SIMD path rounds like the scalar one; only NaN payloads may differ,
+// and vcvtneps2bf16 flushes bf16 subnormals (below 1.2e-38) to zero.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__host__)
+#define HALF_HD __host__ __device__
+#else
+#define HALF_HD
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__HIP_DEVICE_COMPILE__)
+#define HALF_CONVERT_X86 1
+#include <immintrin.h>
+#endif
+
+HALF_HD inline uint32_t half_float_bits(float f) {
+    uint32_t u;
+    __builtin_memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+HALF_HD inline float half_bits_float(uint32_t u) {
+    float f;
+    __builtin_memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// IEEE binary16 -> fp32, exact
+HALF_HD inline float fp16_to_float(uint16_t h) {
+    const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    const uint32_t exp = (h >> 10) & 0x1f;
+    const uint32_t mant = h & 0x3ff;
+    if (exp == 0) {
+        // Zero or subnormal: mant * 2^-24 is exact in fp32
+        return half_bits_float(sign | half_float_bits((float)mant * 5.9604644775390625e-8f));
+    }
+    if (exp == 31) return half_bits_float(sign | 0x7f800000 | (mant << 13));
+    return half_bits_float(sign | ((exp + 112) << 23) | (mant << 13));
+}
+
+// fp32 -> IEEE binary16, round to nearest even; overflow gives +-inf
+HALF_HD inline uint16_t float_to_fp16(float f) {
+    uint32_t u = half_float_bits(f);
+    const uint16_t sign = (uint16_t)((u >> 16) & 0x8000);
+    u &= 0x7fffffff;
+    if (u >= 0x47800000) {
+        // >= 65536, inf or NaN
+        return sign | (u > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+    if (u < 0x38800000) {
+        // Result is subnormal: adding 0.5 aligns the mantissa at 2^-24 and
+        // lets the FPU round to nearest even
+        return sign | (uint16_t)(half_float_bits(half_bits_float(u) + 0.5f) - 0x3f000000);
+    }
+    const uint32_t odd = (u >> 13) & 1;
+    u += 0xc8000fff + odd;  // rebias exponent (127 -> 15) and round
+    return sign | (uint16_t)(u >> 13);
+}
+
+HALF_HD inline float bf16_to_float(uint16_t h) {
+    return half_bits_float((uint32_t)h << 16);
+}
+
+// fp32 -> bfloat16, round to nearest even; NaNs stay quiet NaNs
+HALF_HD inline uint16_t float_to_bf16(float f) {
+    const uint32_t u = half_float_bits(f);
+    if ((u & 0x7fffffff) > 0x7f800000) return (uint16_t)((u >> 16) | 0x40);
+    return (uint16_t)((u + 0x7fff + ((u >> 16) & 1)) >> 16);
+}
+
+// Format tags for the templated softmax kernels
+struct Fp16Format {
+    HALF_HD static float load(uint16_t h) { return fp16_to_float(h); }
+    HALF_HD static uint16_t store(float f) { return float_to_fp16(f); }
+};
+
+struct Bf16Format {
+    HALF_HD static float load(uint16_t h) { return bf16_to_float(h); }
+    HALF_HD static uint16_t store(float f) { return float_to_bf16(f); }
+};
+
+#if !defined(__HIP_DEVICE_COMPILE__)
+namespace half_convert {
+
+#if defined(HALF_CONVERT_X86)
+__attribute__((target("avx,f16c"))) inline void fp16_to_float_f16c(const uint16_t* in, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+    }
+    for (; i < n; ++i) out[i] = fp16_to_float(in[i]);
+}
+
+__attribute__((target("avx,f16c"))) inline void float_to_fp16_f16c(const float* in, uint16_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+    }
+    for (; i < n; ++i) out[i] = float_to_fp16(in[i]);
+}
+
+__attribute__((target("avx2"))) inline void bf16_to_float_avx2(const uint16_t* in, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m256i w = _mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16);
+        _mm256_storeu_ps(out + i, _mm256_castsi256_ps(w));
+    }
+    for (; i < n; ++i) out[i] = bf16_to_float(in[i]);
+}
+
+__attribute__((target("avx2"))) inline void float_to_bf16_avx2(const float* in, uint16_t* out, size_t n) {
+    const __m256i bias = _mm256_set1_epi32(0x7fff);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i abs_mask = _mm256_set1_epi32(0x7fffffff);
+    const __m256i inf = _mm256_set1_epi32(0x7f800000);
+    const __m256i quiet = _mm256_set1_epi32(0x400000);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i u = _mm256_castps_si256(_mm256_loadu_ps(in + i));
+        __m256i odd = _mm256_and_si256(_mm256_srli_epi32(u, 16), one);
+        __m256i r = _mm256_add_epi32(u, _mm256_add_epi32(bias, odd));
+        __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(u, abs_mask), inf);
+        r = _mm256_blendv_epi8(r, _mm256_or_si256(u, quiet), nan);
+        r = _mm256_srli_epi32(r, 16);
+        // Pack 8 x 32-bit to 8 x 16-bit; packus works per 128-bit lane
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    for (; i < n; ++i) out[i] = float_to_bf16(in[i]);
+}
+
+__attribute__((target("avx512f,avx512vl,avx512bf16"))) inline void float_to_bf16_avx512(const float* in, uint16_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), (__m256i)h);
+    }
+    for (; i < n; ++i) out[i] = float_to_bf16(in[i]);
+}
+
+// CPU features, probed once
+struct Features {
+    bool f16c, avx2, avx512bf16;
+    Features()
+        : f16c(__builtin_cpu_supports("f16c")),
+          avx2(__builtin_cpu_supports("avx2")),
+          avx512bf16(__builtin_cpu_supports("avx512bf16") && __builtin_cpu_supports("avx512vl")) {}
+};
+
+inline const Features& features() {
+    static const Features f;
+    return f;
+}
+#endif
+
+inline void fp16_to_float_n(const uint16_t* in, float* out, size_t n) {
+#if defined(HALF_CONVERT_X86)
+    if (features().f16c) return fp16_to_float_f16c(in, out, n);
+#endif
+    for (size_t i = 0; i < n; ++i) out[i] = fp16_to_float(in[i]);
+}
+
+inline void float_to_fp16_n(const float* in, uint16_t* out, size_t n) {
+#if defined(HALF_CONVERT_X86)
+    if (features().f16c) return float_to_fp16_f16c(in, out, n);
+#endif
+    for (size_t i = 0; i < n; ++i) out[i] = float_to_fp16(in[i]);
+}
+
+inline void bf16_to_float_n(const uint16_t* in, float* out, size_t n) {
+#if defined(HALF_CONVERT_X86)
+    if (features().avx2) return bf16_to_float_avx2(in, out, n);
+#endif
+    for (size_t i = 0; i < n; ++i) out[i] = bf16_to_float(in[i]);
+}
+
+inline void float_to_bf16_n(const float* in, uint16_t* out, size_t n) {
+#if defined(HALF_CONVERT_X86)
+    if (features().avx512bf16) return float_to_bf16_avx512(in, out, n);
+    if (features().avx2) return float_to_bf16_avx2(in, out, n);
+#endif
+    for (size_t i = 0; i < n; ++i) out[i] = float_to_bf16(in[i]);
+}
+
+// Bulk converters selected by format, for the templated host code
+template <typename Fmt> struct Bulk;
+
+template <> struct Bulk<Fp16Format> {
+    static void to_float(const uint16_t* in, float* out, size_t n) { fp16_to_float_n(in, out, n); }
+    static void from_float(const float* in, uint16_t* out, size_t n) { float_to_fp16_n(in, out, n); }
+};
+
+template <> struct Bulk<Bf16Format> {
+    static void to_float(const uint16_t* in, float* out, size_t n) { bf16_to_float_n(in, out, n); }
+    static void from_float(const float* in, uint16_t* out, size_t n) { float_to_bf16_n(in, out, n); }
+};
+
+}  // namespace half_convert
+#endif
+
+#endif
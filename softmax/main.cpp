@@ -1,38 +1,190 @@
 #include "main.h"
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include "float_io.h"
+#include "half_convert.h"
+#include "../common/numa_alloc.h"
+#include "../common/solver_server.h"
 
 // Use the solve wrapper which chooses CPU or GPU based on N
 extern "C" void solve(const float* input, float* output, int N);
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "usage: " << argv[0] << " <input_file>" << std::endl;
-        return 1;
+static const char* USAGE_OPTIONS = "<input_file> [--log | --topk K | --sample T SEED | --dtype fp16|bf16] [--precision P]";
+
+static void print_usage(const char* prog) {
+    std::cerr << "usage: " << prog << " " << USAGE_OPTIONS << std::endl;
+    std::cerr << "       --topk K selects on the GPU for K <= 32; larger K uses a size-K heap on the host" << std::endl;
+    std::cerr << "       " << prog << " --serve <socket>" << std::endl;
+}
+
+// Job options as given after <input_file>
+struct SoftmaxOptions {
+    std::string mode;
+    int topk = 0;
+    float temperature = 1.0f;
+    unsigned seed = 0;
+    std::string dtype;
+    int precision = FLOAT_IO_DEFAULT_PRECISION;
+};
+
+// Output mode: full probabilities by default; --log writes log-softmax in
+// place, --topk prints k (index, prob) pairs, --sample prints one index,
+// --dtype rounds the input to fp16 / bf16 and runs the half-precision path.
+// --precision P sets significant digits (default 6, as iostream); 0 prints
+// the shortest round-trip form
+static bool parse_options(const std::vector<std::string>& args, SoftmaxOptions& opt) {
+    for (size_t a = 1; a < args.size(); ++a) {
+        const std::string& arg = args[a];
+        if (arg == "--log" && opt.mode.empty()) {
+            opt.mode = arg;
+        } else if (arg == "--topk" && opt.mode.empty() && a + 1 < args.size()) {
+            opt.mode = arg;
+            opt.topk = std::atoi(args[++a].c_str());
+        } else if (arg == "--sample" && opt.mode.empty() && a + 2 < args.size()) {
+            opt.mode = arg;
+            opt.temperature = std::strtof(args[++a].c_str(), nullptr);
+            opt.seed = (unsigned)std::strtoul(args[++a].c_str(), nullptr, 10);
+        } else if (arg == "--dtype" && opt.mode.empty() && a + 1 < args.size()) {
+            opt.mode = arg;
+            opt.dtype = args[++a];
+            if (opt.dtype != "fp16" && opt.dtype != "bf16") return false;
+        } else if (arg == "--precision" && a + 1 < args.size()) {
+            opt.precision = std::atoi(args[++a].c_str());
+        } else {
+            return false;
+        }
     }
-    
-    std::ifstream input_file;
-    std::string filename = argv[1];
-    
-    input_file.open(filename);
-    if (!input_file.is_open()) {
-        std::cerr << "fileopen error" << filename << std::endl;
-        return 1;
+    return true;
+}
+
+// Solves an already loaded input and writes the result text to out_fd
+static bool write_result(const SoftmaxOptions& opt, numa_alloc::vector<float>& input, int out_fd) {
+    int N = (int)input.size();
+
+    if (opt.mode == "--topk") {
+        std::vector<int> indices(std::max(opt.topk, 0));
+        std::vector<float> probs(std::max(opt.topk, 0));
+        int k = solve_topk(input.data(), N, opt.topk, indices.data(), probs.data());
+        std::ostringstream out;
+        for (int r = 0; r < k; ++r) {
+            out << indices[r] << " " << probs[r] << "\n";
+        }
+        return fd_io::write_all(out_fd, out.str().data(), out.str().size());
+    }
+    if (opt.mode == "--sample") {
+        std::mt19937 rng(opt.seed);
+        double u = std::generate_canonical<double, 53>(rng);
+        std::string line = std::to_string(solve_sample(input.data(), N, opt.temperature, u)) + "\n";
+        return fd_io::write_all(out_fd, line.data(), line.size());
     }
-    int N;
-    input_file >> N;
 
-    std::vector<float> input(N), output(N);
+    if (opt.mode == "--dtype") {
+        std::vector<uint16_t> half_in(N), half_out(N);
+        numa_alloc::vector<float> output(N);
+        float_io::first_touch_output(output.data(), N);
+        if (opt.dtype == "fp16") {
+            half_convert::float_to_fp16_n(input.data(), half_in.data(), N);
+            solve_fp16(half_in.data(), half_out.data(), N);
+            half_convert::fp16_to_float_n(half_out.data(), output.data(), N);
+        } else {
+            half_convert::float_to_bf16_n(input.data(), half_in.data(), N);
+            solve_bf16(half_in.data(), half_out.data(), N);
+            half_convert::bf16_to_float_n(half_out.data(), output.data(), N);
+        }
+        numa_alloc::report("output", output.data(), output.size() * sizeof(float));
+        return float_io::write_floats(out_fd, output.data(), N, opt.precision);
+    }
 
-    for(int i = 0; i < N; ++i) input_file >> input[i];
+    numa_alloc::vector<float> output;
+    if (opt.mode == "--log") {
+        solve_log_softmax(input.data(), N);
+        output.swap(input);
+    } else {
+        // Pages follow write_floats, the host pass that reads the output
+        output.resize(N);
+        float_io::first_touch_output(output.data(), N);
+        solve(input.data(), output.data(), N);
+    }
+    numa_alloc::report("output", output.data(), output.size() * sizeof(float));
+    return float_io::write_floats(out_fd, output.data(), N, opt.precision);
+}
 
-    input_file.close();
+// One job: args = {input_file, options...}
+static bool run_job(const std::vector<std::string>& args, int out_fd, std::string& err) {
+    SoftmaxOptions opt;
+    if (!parse_options(args, opt)) {
+        err = std::string("usage: ") + USAGE_OPTIONS;
+        return false;
+    }
+    numa_alloc::vector<float> input;
+    if (!float_io::read_float_file(args[0], input)) {
+        err = "fileopen error" + args[0];
+        return false;
+    }
+    numa_alloc::report("input", input.data(), input.size() * sizeof(float));
+    return write_result(opt, input, out_fd);
+}
+
+// Server batch: plain softmax jobs up to SOFTMAX_BATCH_MAX_N are packed
+// into one solve_batch launch; everything else runs on its own
+static void serve_batch(std::vector<solver_server::Job>& batch) {
+    std::vector<solver_server::Job*> packed;
+    std::vector<numa_alloc::vector<float>> rows;
+    std::vector<SoftmaxOptions> row_opts;
+    for (solver_server::Job& job : batch) {
+        SoftmaxOptions opt;
+        if (parse_options(job.args, opt) && opt.mode.empty()) {
+            numa_alloc::vector<float> input;
+            if (!float_io::read_float_file(job.args[0], input)) {
+                job.error = "fileopen error" + job.args[0];
+                continue;
+            }
+            if (!input.empty() && input.size() <= SOFTMAX_BATCH_MAX_N) {
+                packed.push_back(&job);
+                rows.push_back(std::move(input));
+                row_opts.push_back(opt);
+                continue;
+            }
+            if (!write_result(opt, input, job.out_fd)) job.error = "write failed";
+            continue;
+        }
+        if (!run_job(job.args, job.out_fd, job.error) && job.error.empty()) job.error = "write failed";
+    }
+    if (packed.empty()) return;
+
+    std::vector<int> offsets(rows.size() + 1, 0);
+    for (size_t r = 0; r < rows.size(); ++r) offsets[r + 1] = offsets[r] + (int)rows[r].size();
+    std::vector<float> input(offsets.back()), output(offsets.back());
+    for (size_t r = 0; r < rows.size(); ++r) {
+        std::copy(rows[r].begin(), rows[r].end(), input.begin() + offsets[r]);
+    }
+    solve_batch(input.data(), offsets.data(), output.data(), (int)rows.size());
+    for (size_t r = 0; r < rows.size(); ++r) {
+        if (!float_io::write_floats(packed[r]->out_fd, output.data() + offsets[r],
+                                    (int)rows[r].size(), row_opts[r].precision)) {
+            packed[r]->error = "write failed";
+        }
+    }
+}
 
-    solve(input.data(), output.data(), N);
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--serve") {
+        return solver_server::serve(argv[2], "softmax", serve_batch);
+    }
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
 
-    for(int i = 0; i < N; ++i) {
-        std::cout << output[i];
-        if (i < N - 1) std::cout << " ";
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::string err;
+    if (!run_job(args, STDOUT_FILENO, err)) {
+        if (err.compare(0, 6, "usage:") == 0) print_usage(argv[0]);
+        else if (!err.empty()) std::cerr << err << std::endl;
+        return 1;
     }
-    std::cout << " " << std::endl;
-    
+
     return 0;
 }
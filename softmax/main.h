@@ -7,7 +7,24 @@
 #include <hip/hip_runtime.h>
 #include <float.h>
 #include <fstream>
+#include <cstdint>
 
 extern "C" void solve(const float* input, float* output, int N);
 
+// Fused variants that reuse the max/sum reductions instead of writing N probabilities
+extern "C" void solve_log_softmax(float* data, int N);
+extern "C" int solve_topk(const float* input, int N, int k, int* indices, float* probs);
+extern "C" int solve_sample(const float* input, int N, float temperature, double u);
+
+// Independent rows packed back to back, row r = input[offsets[r], offsets[r + 1]);
+// the server merges concurrent small jobs (N <= SOFTMAX_BATCH_MAX_N) into one call
+#define SOFTMAX_BATCH_MAX_N 65536
+extern "C" void solve_batch(const float* input, const int* offsets, float* output, int rows);
+
+// Half-precision input and output as raw IEEE fp16 / bfloat16 bit patterns;
+// fp32 on the device, block sums folded in double on the host; accuracy
+// bounds are listed in README.md
+extern "C" void solve_fp16(const uint16_t* input, uint16_t* output, int N);
+extern "C" void solve_bf16(const uint16_t* input, uint16_t* output, int N);
+
 #endif 
\ No newline at end of file
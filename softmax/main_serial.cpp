@@ -2,6 +2,12 @@
 #include <algorithm>
 #include <cmath>
 #include <cfloat>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include "float_io.h"
+#include "half_convert.h"
+#include "../common/numa_alloc.h"
 
 // 串行实现的 softmax 函数
 void solve_serial(const float* input, float* output, int N) {
@@ -25,40 +31,266 @@ void solve_serial(const float* input, float* output, int N) {
     }
 }
 
+// log-softmax：y_i = x_i - max - log(sum)，原地写回，不需要输出缓冲区
+void solve_serial_log_softmax(float* data, int N) {
+    if (N <= 0) return;
+
+    float max_val = -FLT_MAX;
+    for (int i = 0; i < N; i++) {
+        max_val = std::max(max_val, data[i]);
+    }
+
+    double total_sum = 0.0;
+    for (int i = 0; i < N; i++) {
+        total_sum += (double)expf(data[i] - max_val);
+    }
+
+    const float shift = (float)((double)max_val + std::log(total_sum));
+    for (int i = 0; i < N; i++) {
+        data[i] = data[i] - shift;
+    }
+}
+
+// 排序规则：值大者在前，值相同时下标小者在前（与 GPU 版本一致）
+static inline bool topk_before(float a, int ia, float b, int ib) {
+    return a > b || (a == b && ia < ib);
+}
+
+// top-k：第一遍求 max，第二遍在累加 sum 的同时维护大小为 k 的小顶堆
+int solve_serial_topk(const float* input, int N, int k, int* indices, float* probs) {
+    if (N <= 0 || k <= 0) return 0;
+    k = std::min(k, N);
+
+    float max_val = -FLT_MAX;
+    for (int i = 0; i < N; i++) {
+        max_val = std::max(max_val, input[i]);
+    }
+
+    // 堆顶是当前 k 个候选中最差的一个
+    auto worse_on_top = [&](int a, int b) { return topk_before(input[a], a, input[b], b); };
+    std::vector<int> heap;
+    heap.reserve(k);
+
+    double total_sum = 0.0;
+    for (int i = 0; i < N; i++) {
+        total_sum += (double)expf(input[i] - max_val);
+        if ((int)heap.size() < k) {
+            heap.push_back(i);
+            std::push_heap(heap.begin(), heap.end(), worse_on_top);
+        } else if (topk_before(input[i], i, input[heap[0]], heap[0])) {
+            std::pop_heap(heap.begin(), heap.end(), worse_on_top);
+            heap.back() = i;
+            std::push_heap(heap.begin(), heap.end(), worse_on_top);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), worse_on_top);
+    for (int r = 0; r < k; r++) {
+        indices[r] = heap[r];
+        probs[r] = (float)((double)expf(input[heap[r]] - max_val) / total_sum);
+    }
+    return k;
+}
+
+// 温度采样：第二遍按 SAMPLE_CHUNK 分段累加 exp，得到分段前缀和；
+// 逆 CDF 查找先定位分段，再只在该分段内逐项扫描
+#define SAMPLE_CHUNK 4096
+
+int solve_serial_sample(const float* input, int N, float temperature, double u) {
+    if (N <= 0) return -1;
+
+    float max_val = -FLT_MAX;
+    int argmax = 0;
+    for (int i = 0; i < N; i++) {
+        if (input[i] > max_val) {
+            max_val = input[i];
+            argmax = i;
+        }
+    }
+    // 温度为 0（或负数）退化为贪心取最大值
+    if (!(temperature > 0.0f)) return argmax;
+
+    const float inv_t = 1.0f / temperature;
+    const int num_chunks = (N + SAMPLE_CHUNK - 1) / SAMPLE_CHUNK;
+    std::vector<double> chunk_sum(num_chunks);
+    double total_sum = 0.0;
+    for (int c = 0; c < num_chunks; c++) {
+        const int end = std::min(N, (c + 1) * SAMPLE_CHUNK);
+        double s = 0.0;
+        for (int i = c * SAMPLE_CHUNK; i < end; i++) {
+            s += (double)expf((input[i] - max_val) * inv_t);
+        }
+        chunk_sum[c] = s;
+        total_sum += s;
+    }
+
+    double target = u * total_sum;
+    int c = 0;
+    while (c < num_chunks - 1 && target >= chunk_sum[c]) {
+        target -= chunk_sum[c];
+        c++;
+    }
+
+    const int end = std::min(N, (c + 1) * SAMPLE_CHUNK);
+    int last_nonzero = c * SAMPLE_CHUNK;
+    for (int i = c * SAMPLE_CHUNK; i < end; i++) {
+        const double p = (double)expf((input[i] - max_val) * inv_t);
+        if (p > 0.0) last_nonzero = i;
+        if (target < p) return i;
+        target -= p;
+    }
+    // 舍入误差导致越过分段末尾时，取分段内最后一个非零概率项
+    return last_nonzero;
+}
+
+// 半精度（fp16 / bf16）softmax：输入输出均为 16 位，内部以 fp32 计算，
+// exp 之和以 double 累加（N 可达 1e8，float 顺序累加的误差会超过 README 中的界）。
+// 每次把 HALF_CHUNK 个元素经 SIMD 批量转换到栈上的 fp32 缓冲区（驻留 L1），
+// 第一遍用在线算法同时得到 max 与 sum（块内先求 max 再求 exp 和，块间按
+// exp(旧max - 新max) 重新缩放），第二遍归一化后批量转换回 16 位写出。
+// 与 float 版本的三遍相比，只读两遍输入，且每个元素只搬运 2 字节。
+#define HALF_CHUNK 1024
+
+template <typename Fmt>
+static void solve_serial_half(const uint16_t* input, uint16_t* output, int N) {
+    if (N <= 0) return;
+    typedef half_convert::Bulk<Fmt> Bulk;
+    float buf[HALF_CHUNK];
+
+    float run_max = -FLT_MAX;
+    double run_sum = 0.0;
+    for (int c = 0; c < N; c += HALF_CHUNK) {
+        const int n = std::min(HALF_CHUNK, N - c);
+        Bulk::to_float(input + c, buf, n);
+        float m = -FLT_MAX;
+        for (int i = 0; i < n; i++) m = std::max(m, buf[i]);
+        double s = 0.0;
+        for (int i = 0; i < n; i++) s += expf(buf[i] - m);
+        if (m > run_max) {
+            run_sum = run_sum * exp((double)run_max - m) + s;
+            run_max = m;
+        } else {
+            run_sum += s * exp((double)m - run_max);
+        }
+    }
+
+    const float inv_sum = (float)(1.0 / run_sum);
+    for (int c = 0; c < N; c += HALF_CHUNK) {
+        const int n = std::min(HALF_CHUNK, N - c);
+        Bulk::to_float(input + c, buf, n);
+        for (int i = 0; i < n; i++) buf[i] = expf(buf[i] - run_max) * inv_sum;
+        Bulk::from_float(buf, output + c, n);
+    }
+}
+
+void solve_serial_fp16(const uint16_t* input, uint16_t* output, int N) {
+    solve_serial_half<Fp16Format>(input, output, N);
+}
+
+void solve_serial_bf16(const uint16_t* input, uint16_t* output, int N) {
+    solve_serial_half<Bf16Format>(input, output, N);
+}
+
+static void print_usage(const char* prog) {
+    std::cerr << "usage: " << prog << " <input_file> [--log | --topk K | --sample T SEED | --dtype fp16|bf16] [--precision P]" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "usage: " << argv[0] << " <input_file>" << std::endl;
+    if (argc < 2) {
+        print_usage(argv[0]);
         return 1;
     }
+
+    // 输出模式：默认输出完整概率；--log 原地 log-softmax；
+    // --topk 只输出 k 个 (下标, 概率)；--sample 只输出一个采样下标；
+    // --dtype fp16|bf16 先把输入舍入到该格式，再走半精度 softmax；
+    // --precision P 指定有效数字位数（默认 6，与 iostream 一致），0 为最短可回读表示
+    std::string mode;
+    std::string dtype;
+    int topk = 0;
+    float temperature = 1.0f;
+    unsigned seed = 0;
+    int precision = FLOAT_IO_DEFAULT_PRECISION;
+    for (int a = 2; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (arg == "--log" && mode.empty()) {
+            mode = arg;
+        } else if (arg == "--topk" && mode.empty() && a + 1 < argc) {
+            mode = arg;
+            topk = std::atoi(argv[++a]);
+        } else if (arg == "--sample" && mode.empty() && a + 2 < argc) {
+            mode = arg;
+            temperature = std::strtof(argv[++a], nullptr);
+            seed = (unsigned)std::strtoul(argv[++a], nullptr, 10);
+        } else if (arg == "--dtype" && mode.empty() && a + 1 < argc) {
+            mode = arg;
+            dtype = argv[++a];
+            if (dtype != "fp16" && dtype != "bf16") {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--precision" && a + 1 < argc) {
+            precision = std::atoi(argv[++a]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
     
-    std::ifstream input_file;
     std::string filename = argv[1];
-    
-    input_file.open(filename);
-    if (!input_file.is_open()) {
+    numa_alloc::vector<float> input;
+    if (!float_io::read_float_file(filename, input)) {
         std::cerr << "fileopen error " << filename << std::endl;
         return 1;
     }
-    
-    int N;
-    input_file >> N;
-
-    std::vector<float> input(N), output(N);
+    int N = (int)input.size();
+    numa_alloc::report("input", input.data(), input.size() * sizeof(float));
 
-    for(int i = 0; i < N; ++i) {
-        input_file >> input[i];
+    if (mode == "--topk") {
+        std::vector<int> indices(std::max(topk, 0));
+        std::vector<float> probs(std::max(topk, 0));
+        int k = solve_serial_topk(input.data(), N, topk, indices.data(), probs.data());
+        for (int r = 0; r < k; ++r) {
+            std::cout << indices[r] << " " << probs[r] << std::endl;
+        }
+        return 0;
+    }
+    if (mode == "--sample") {
+        std::mt19937 rng(seed);
+        double u = std::generate_canonical<double, 53>(rng);
+        std::cout << solve_serial_sample(input.data(), N, temperature, u) << std::endl;
+        return 0;
     }
 
-    input_file.close();
-
-    // 调用串行实现
-    solve_serial(input.data(), output.data(), N);
+    if (mode == "--dtype") {
+        std::vector<uint16_t> half_in(N), half_out(N);
+        numa_alloc::vector<float> output(N);
+        if (dtype == "fp16") {
+            half_convert::float_to_fp16_n(input.data(), half_in.data(), N);
+            solve_serial_fp16(half_in.data(), half_out.data(), N);
+            half_convert::fp16_to_float_n(half_out.data(), output.data(), N);
+        } else {
+            half_convert::float_to_bf16_n(input.data(), half_in.data(), N);
+            solve_serial_bf16(half_in.data(), half_out.data(), N);
+            half_convert::bf16_to_float_n(half_out.data(), output.data(), N);
+        }
+        numa_alloc::report("output", output.data(), output.size() * sizeof(float));
+        float_io::write_floats(STDOUT_FILENO, output.data(), N, precision);
+        return 0;
+    }
 
-    for(int i = 0; i < N; ++i) {
-        std::cout << output[i];
-        if (i < N - 1) std::cout << " ";
+    numa_alloc::vector<float> output;
+    if (mode == "--log") {
+        solve_serial_log_softmax(input.data(), N);
+        output.swap(input);
+    } else {
+        // 调用串行实现；串行基线不做并行首次写入，输出页面由计算线程写入
+        output.resize(N);
+        solve_serial(input.data(), output.data(), N);
     }
-    std::cout << " " << std::endl;
+    numa_alloc::report("output", output.data(), output.size() * sizeof(float));
+
+    float_io::write_floats(STDOUT_FILENO, output.data(), N, precision);
     
     return 0;
 }
@@ -6,8 +6,21 @@
 #include <vector>
 #include <fstream>
 #include <float.h>
+#include <cstdint>
 
 // 串行版本的 softmax 函数声明
 void solve_serial(const float* input, float* output, int N);
 
+// 融合变体：复用 max / sum 归约，不写出完整的 N 个概率
+// log-softmax，原地写回 data
+void solve_serial_log_softmax(float* data, int N);
+// 概率最大的 k 项，按概率降序写入 indices / probs，返回实际写出的个数
+int solve_serial_topk(const float* input, int N, int k, int* indices, float* probs);
+// 按 softmax(x / temperature) 采样一个下标，u 为 [0,1) 均匀随机数
+int solve_serial_sample(const float* input, int N, float temperature, double u);
+
+// 半精度输入输出（IEEE fp16 / bfloat16 的原始位模式），exp 与归一化为 fp32，exp 之和以 double 累加
+void solve_serial_fp16(const uint16_t* input, uint16_t* output, int N);
+void solve_serial_bf16(const uint16_t* input, uint16_t* output, int N);
+
 #endif
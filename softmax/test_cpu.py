@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# CPU 后端回归测试：用 common/hip_cpu 编译出的 softmax_cpu 与串行基线 softmax_serial
+# 在随机输入上逐项比较（默认 / --log / --topk / --sample / --dtype），容差同评分器。
+#
+# 用法: python3 test_cpu.py ./softmax_serial ./softmax_cpu
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+# (N, 取值范围, 说明)；覆盖单元素、块边界、多块归约与主机回退的 top-k
+CASES = [
+    (1, 5.0, "single"),
+    (255, 10.0, "partial block"),
+    (256, 10.0, "one block"),
+    (1000, 20.0, "small"),
+    (65537, 30.0, "batch limit + 1"),
+    (300000, 50.0, "many blocks"),
+]
+MODES = [
+    ([], 1e-5, 1e-6),
+    (["--log"], 1e-5, 1e-4),
+    (["--topk", "5"], 1e-5, 1e-6),
+    (["--topk", "32"], 1e-5, 1e-6),
+    (["--topk", "100"], 1e-5, 1e-6),  # 大于 TOPK_MAX，走主机选择
+    (["--sample", "0", "1"], 0, 0),
+    (["--sample", "1", "7"], 0, 0),
+    (["--dtype", "fp16"], 2.0 ** -10, 2.0 ** -25),
+    (["--dtype", "bf16"], 2.0 ** -7, 2.0 ** -25),
+]
+
+
+def close(a, b, rtol, atol):
+    return abs(a - b) <= atol + rtol * max(abs(a), abs(b))
+
+
+def compare(ref, got, rtol, atol, topk):
+    """Returns None when the outputs agree, else a short description."""
+    r, g = ref.split(), got.split()
+    if len(r) != len(g):
+        return "%d values, expected %d" % (len(g), len(r))
+    for i, (x, y) in enumerate(zip(r, g)):
+        if x == y:
+            continue
+        # top-k 每行 "下标 概率"，下标必须完全一致；采样结果同理
+        exact = rtol == 0 or (topk and i % 2 == 0)
+        if exact or not close(float(x), float(y), rtol, atol):
+            return "[%d] got %s, expected %s" % (i, y, x)
+    return None
+
+
+def run(binary, path, opts):
+    return subprocess.run([binary, path] + opts, stdout=subprocess.PIPE,
+                          stderr=subprocess.DEVNULL, check=True).stdout.decode()
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("usage: test_cpu.py <serial_binary> <cpu_binary>")
+        return 2
+    serial, cpu = sys.argv[1], sys.argv[2]
+    rng = random.Random(2024)
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "x.in")
+        for n, scale, what in CASES:
+            with open(path, "w") as f:
+                f.write("%d\n" % n)
+                f.write(" ".join("%.6g" % rng.uniform(-scale, scale) for _ in range(n)))
+                f.write("\n")
+            for opts, rtol, atol in MODES:
+                err = compare(run(serial, path, opts), run(cpu, path, opts), rtol, atol, "--topk" in opts)
+                if err:
+                    failed += 1
+                    print("FAIL N=%d (%s) %s: %s" % (n, what, " ".join(opts) or "softmax", err))
+    print("test_cpu: %s" % ("FAIL" if failed else "PASS"))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())